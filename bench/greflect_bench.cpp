@@ -0,0 +1,280 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+// @note: greflect-bench -g <greflect> -o <work directory>
+//                       [-n classes] [-m methods] [-k overloads]
+//                       [-d inheritance depth] [-i heavy includes]
+//                       [-r repeats] [-- <greflect options>]
+//        Each dimension takes list of values separated by ','. For every
+//        combination a synthetic input is generated, greflect is run on it
+//        and wall time, peak RSS and size of output are printed as one
+//        row of tab separated table. Best of repeats is taken.
+
+#include <fcntl.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+typedef std::vector<std::string> strings;
+typedef std::vector<unsigned> values;
+
+// @struct dimensions
+struct dimensions
+{
+	unsigned classes;
+	unsigned methods;
+	unsigned overloads;
+	unsigned depth;
+	unsigned includes;
+}; // struct dimensions
+
+// @struct measurement
+struct measurement
+{
+	int status;
+	double seconds;
+	long peak_kb;
+	long long output_bytes;
+}; // struct measurement
+
+// @note: Parameter types of overloads, commas inside template arguments
+//        are on purpose.
+const char* const parameter_types[] = {
+	"int",
+	"double",
+	"const std::string&",
+	"std::map<int, int>",
+	"const std::vector<std::pair<int, long> >&",
+	"bool",
+	"unsigned long long",
+	"const char*"
+};
+
+const unsigned parameter_type_count = sizeof(parameter_types) / sizeof(parameter_types[0]);
+
+std::string get_file_name(const std::string& directory, const std::string& name)
+{
+	return directory + "/" + name;
+}
+
+//@brief Heavy include: many declarations greflect must not reflect.
+void generate_include(const std::string& file_name, unsigned index)
+{
+	std::ofstream out(file_name.c_str());
+	out << "#pragma once\n#include <map>\n#include <string>\n#include <vector>\n\n";
+	out << "namespace heavy" << index << " {\n\n";
+	for (unsigned c = 0; c < 100; ++c) {
+		out << "struct record" << c << "\n{\n";
+		for (unsigned m = 0; m < 10; ++m) {
+			out << "\tint method" << m << "(int a) const { return a + " << m << "; }\n";
+		}
+		out << "\tstd::map<int, std::string> values;\n};\n\n";
+	}
+	out << "enum class kind { a, b, c };\n\n} // namespace heavy" << index << "\n";
+}
+
+void generate_input(const std::string& file_name, const dimensions& d, const strings& includes)
+{
+	std::ofstream out(file_name.c_str());
+	out << "#include <map>\n#include <string>\n#include <utility>\n#include <vector>\n";
+	for (auto& i : includes) {
+		out << "#include \"" << i << "\"\n";
+	}
+	out << "\n";
+	for (unsigned b = 0; b < d.depth; ++b) {
+		out << "class base" << b;
+		if (0 != b) {
+			out << " : public base" << b - 1;
+		}
+		out << "\n{\npublic:\n\tvirtual ~base" << b << "() {}\n";
+		out << "\tvirtual int level" << b << "() const { return " << b << "; }\n};\n\n";
+	}
+	for (unsigned c = 0; c < d.classes; ++c) {
+		out << "class class" << c;
+		if (0 != d.depth) {
+			out << " : public base" << d.depth - 1;
+		}
+		out << "\n{\npublic:\n";
+		for (unsigned m = 0; m < d.methods; ++m) {
+			for (unsigned k = 0; k < d.overloads; ++k) {
+				out << "\tint method" << m << "(";
+				for (unsigned p = 0; p <= k; ++p) {
+					out << (0 == p ? "" : ", ") << parameter_types[(m + p) % parameter_type_count];
+				}
+				out << ")" << (0 == m % 2 ? " const" : "") << " { return " << k << "; }\n";
+			}
+		}
+		out << "\nprivate:\n\tint m_value;\n\tstd::string m_name;\n};\n\n";
+	}
+}
+
+long long get_file_size(const std::string& file_name)
+{
+	struct stat st;
+	return 0 == ::stat(file_name.c_str(), &st) ? st.st_size : 0;
+}
+
+measurement run(const strings& command)
+{
+	std::vector<char*> argv;
+	for (auto& c : command) {
+		argv.push_back(const_cast<char*>(c.c_str()));
+	}
+	argv.push_back(0);
+	measurement r = {};
+	const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	const pid_t pid = ::fork();
+	if (0 == pid) {
+		const int null = ::open("/dev/null", O_WRONLY);
+		::dup2(null, 1);
+		::execv(argv[0], argv.data());
+		::_exit(127);
+	}
+	int status = 0;
+	struct rusage usage;
+	std::memset(&usage, 0, sizeof(usage));
+	if (-1 == pid || -1 == ::wait4(pid, &status, 0, &usage)) {
+		r.status = -1;
+		return r;
+	}
+	r.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	r.status = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+	r.peak_kb = usage.ru_maxrss;
+	return r;
+}
+
+bool parse_values(const std::string& list, values& vs)
+{
+	std::istringstream in(list);
+	std::string v;
+	while (std::getline(in, v, ',')) {
+		if (v.empty() || std::string::npos != v.find_first_not_of("0123456789")) {
+			return false;
+		}
+		vs.push_back(std::strtoul(v.c_str(), 0, 10));
+	}
+	return !vs.empty();
+}
+
+void usage(const char* path)
+{
+	std::cerr << "Usage: " << path << " -g <greflect> -o <work directory> [-n classes] [-m methods]"
+		  << " [-k overloads] [-d depth] [-i includes] [-r repeats] [-- <greflect options>]\n"
+		  << "  dimensions are lists separated by ',', e.g. -n 10,100,1000\n";
+}
+
+} // unnamed namespace
+
+int main(int argc, char const **argv)
+{
+	std::string greflect;
+	std::string directory;
+	values classes(1, 100), methods(1, 10), overloads(1, 1), depths(1, 0), includes(1, 0);
+	unsigned repeats = 3;
+	strings options;
+	for (int i = 1; i < argc; ++i) {
+		const std::string a = argv[i];
+		if ("--" == a) {
+			options.assign(argv + i + 1, argv + argc);
+			break;
+		}
+		if (i + 1 == argc) {
+			usage(argv[0]);
+			return 1;
+		}
+		const std::string v = argv[++i];
+		values* vs = "-n" == a ? &classes : "-m" == a ? &methods : "-k" == a ? &overloads :
+			     "-d" == a ? &depths : "-i" == a ? &includes : 0;
+		if ("-g" == a) {
+			greflect = v;
+		} else if ("-o" == a) {
+			directory = v;
+		} else if ("-r" == a) {
+			repeats = std::max(1ul, std::strtoul(v.c_str(), 0, 10));
+		} else if (0 == vs || (vs->clear(), !parse_values(v, *vs))) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+	if (greflect.empty() || directory.empty()) {
+		usage(argv[0]);
+		return 1;
+	}
+	::mkdir(directory.c_str(), 0777);
+	const unsigned max_includes = *std::max_element(includes.begin(), includes.end());
+	strings include_names;
+	for (unsigned i = 0; i < max_includes; ++i) {
+		include_names.push_back("heavy" + std::to_string(i) + ".hpp");
+		generate_include(get_file_name(directory, include_names.back()), i);
+	}
+	std::cout << "classes\tmethods\toverloads\tdepth\tincludes\tseconds\tpeak_kb\toutput_bytes\n";
+	int failed = 0;
+	std::vector<dimensions> combinations;
+	for (auto n : classes) {
+		for (auto m : methods) {
+			for (auto k : overloads) {
+				for (auto d : depths) {
+					for (auto h : includes) {
+						const dimensions dims = { n, m, k, d, h };
+						combinations.push_back(dims);
+					}
+				}
+			}
+		}
+	}
+	for (auto& dims : combinations) {
+		const std::string name = "input_" + std::to_string(dims.classes) + "_" + std::to_string(dims.methods) + "_" +
+					 std::to_string(dims.overloads) + "_" + std::to_string(dims.depth) + "_" +
+					 std::to_string(dims.includes);
+		const std::string input = get_file_name(directory, name + ".hpp");
+		const std::string output = get_file_name(directory, name + "_reflected.hpp");
+		generate_input(input, dims, strings(include_names.begin(), include_names.begin() + dims.includes));
+		strings command;
+		command.push_back(greflect);
+		command.push_back("-i");
+		command.push_back(input);
+		command.push_back("-o");
+		command.push_back(output);
+		command.insert(command.end(), options.begin(), options.end());
+		measurement best = {};
+		for (unsigned r = 0; r < repeats; ++r) {
+			::unlink(output.c_str());
+			const measurement current = run(command);
+			if (0 == r || current.seconds < best.seconds) {
+				best = current;
+			}
+		}
+		best.output_bytes = get_file_size(output);
+		std::cout << dims.classes << "\t" << dims.methods << "\t" << dims.overloads << "\t"
+			  << dims.depth << "\t" << dims.includes << "\t";
+		if (0 != best.status) {
+			std::cout << "failed with " << best.status << "\n";
+			++failed;
+			continue;
+		}
+		std::cout << best.seconds << "\t" << best.peak_kb << "\t" << best.output_bytes << std::endl;
+	}
+	return 0 == failed ? 0 : 1;
+}
@@ -1,310 +1,939 @@
-/*
-* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
-* Permission is hereby granted, free of charge, to any person obtaining a copy
-* of this software and associated documentation files (the "Software"), to deal
-* in the Software without restriction, including without limitation the rights
-* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-* copies of the Software, and to permit persons to whom the Software is
-* furnished to do so, subject to the following conditions:
-*/
-
-#ifndef APPLICATION_HPP
-#define APPLICATION_HPP
-
-#include "debug.hpp"
-#include "messenger.hpp"
-#include "option.hpp"
-#include "reflect_output.hpp"
-#include "utils.hpp"
-#include "visitor.hpp"
-
-#include <clang/Frontend/CompilerInstance.h>
-#include <clang/Lex/Preprocessor.h>
-#include <clang/Basic/Diagnostic.h>
-#include <clang/Basic/FileManager.h>
-#include <clang/Basic/LangOptions.h>
-#include <clang/Basic/SourceManager.h>
-#include <clang/Basic/TargetInfo.h>
-#include <clang/Basic/TargetOptions.h>
-#include <clang/Parse/ParseAST.h>
-#include <llvm/Support/raw_ostream.h>
-
-#include <string>
-
-namespace reflector {
-
-// @class writer
-class writer
-{
-public:
-	explicit writer(const std::string& file_name)
-		: m_file_name(file_name)
-		, m_do(utils::exist_file(file_name.c_str()) ? "Rewrite" : "Generate")
-	{
-	}
-
-	void write_reflected(const reflected_class::reflected_collection& reflected)
-	{
-		std::error_code error_info;
-		llvm::raw_fd_ostream out_file(llvm::StringRef(m_file_name), error_info, llvm::sys::fs::F_Text);
-		const std::error_code ok;
-		if (ok != error_info) {
-			out_file.close();
-			throw std::runtime_error(error_info.message());
-		}
-		reflect_output out(out_file);
-		out.dump(reflected);
-		out_file.close();
-		massenger::print(m_do + " reflection to " + m_file_name);
-	}
-private:
-	const std::string& m_file_name;
-	std::string m_do;
-	
-}; // class writer
-
-// @class application
-class application
-{
-public:
-	//@brief constructor
-	application(int c, char const **v);
-public:
-	//@brief Runs application.
-	//@return Exit code.
-	int run();
-
-	//@brief Gets application's name.
-	//@return name of application
-	static const std::string& get_name();
-
-	//@brief Gets application's description.
-	//@return description of application
-	static const std::string& get_description();
-private:
-	void initialize_compiler();
-
-	void set_header_search_options();
-
-	void set_invocation();
-
-	void set_default_target_triple();
-	
-	void set_main_file_id();
-
-	void parse_ast();
-
-	void get_options(options&) const;
-
-	bool parse_parameters(unsigned, char const **);
-
-	std::string get_hidden_option_value(const std::string&) const;
-
-	std::string usage(const char*) const;
-
-	std::string version() const;
-
-	std::string help() const;
-private:
-        clang::CompilerInstance m_compiler;
-	std::string m_input_file_name;
-	std::string m_output_file_name;
-}; // class application
-
-application::application(int c, char const **v)
-{
-	if ( parse_parameters(c, v) ) {
-		initialize_compiler();
-	}
-}
-
-const std::string& application::get_name()
-{
-	static const std::string name = "greflect";
-	return name;
-}
-
-const std::string& application::get_description()
-{
-	static const std::string desc = "Generate reflection for C++ programming language";
-	return desc;
-}
-
-std::string application::usage(const char* path) const
-{
-	return std::string(path ) + " -i <input file>";
-}
-
-std::string application::version() const
-{
-	return "Version: a2017.06";
-}
-
-std::string application::help() const
-{
-	std::string h = get_name() + ":  " + get_description() + "\n";
-	h += "Options:\n";
-	options o;
-	get_options(o);
-	o.for_each_option(
-		[&h](const definition& d)
-		{
-			h += "  " + d.get_name() + ": " + d.get_description() +
-			(d.is_optional() ? ": optional" : d.is_hidden() ? "" : ": requared") + "\n"; 
-		}
-	);
-	return h;
-}
-
-void application::initialize_compiler()
-{
-	m_compiler.createDiagnostics();
-	set_header_search_options();
-	set_invocation();
-	set_default_target_triple();
-	m_compiler.createFileManager();
-	m_compiler.createSourceManager(m_compiler.getFileManager());
-	m_compiler.createPreprocessor(clang::TU_Complete);
-	m_compiler.getPreprocessorOpts().UsePredefines = false;
-	m_compiler.createASTContext();
-	set_main_file_id();
-}
-
-void application::set_header_search_options()
-{
-	clang::HeaderSearchOptions &h = m_compiler.getHeaderSearchOpts();
-	h.AddPath("/usr/local/include", clang::frontend::Angled, false, false);
-	h.AddPath("/usr/include", clang::frontend::Angled, false, false);
-	//TODO: should to add an option to allowing user set the path.
-}
-
-void application::set_invocation()
-{
-	ASSERT(m_compiler.hasDiagnostics());
-	clang::CompilerInvocation* invocation = new clang::CompilerInvocation;
-	ASSERT(!m_input_file_name.empty());
-	const char* dummy_arg[1];
-	dummy_arg[0] = m_input_file_name.c_str();
-	clang::CompilerInvocation::CreateFromArgs(*invocation,
-						   dummy_arg,
-						   dummy_arg + 1,
-						   m_compiler.getDiagnostics());
-	clang::LangOptions lang_opts;
-	lang_opts.GNUMode = 1;
-	lang_opts.CXXExceptions = 1;
-	lang_opts.RTTI = 1;
-	lang_opts.Bool = 1;
-	lang_opts.CPlusPlus = 1;
-	invocation->setLangDefaults(lang_opts, clang::IK_CXX, clang::LangStandard::lang_cxx0x);
-	m_compiler.setInvocation(invocation);
-}
-
-void application::set_default_target_triple()
-{
-	std::shared_ptr<clang::TargetOptions> to = std::make_shared<clang::TargetOptions>();
-	to->Triple = llvm::sys::getDefaultTargetTriple();
-	ASSERT(m_compiler.hasDiagnostics());
-	m_compiler.setTarget(clang::TargetInfo::CreateTargetInfo(m_compiler.getDiagnostics(), to));
-}
-
-void application::set_main_file_id()
-{
-	ASSERT(m_compiler.hasSourceManager());
-	const clang::FileEntry* file = m_compiler.getFileManager().getFile(m_input_file_name);
-	ASSERT(0 != file);
-	clang::SourceManager& sc_mgr = m_compiler.getSourceManager();
-	sc_mgr.setMainFileID(sc_mgr.createFileID(file, clang::SourceLocation(), clang::SrcMgr::C_User));	
-}
-
-void application::parse_ast()
-{
-	ASSERT(m_compiler.hasSourceManager());
-	clang::SourceManager& sc_mgr = m_compiler.getSourceManager();
-	ASSERT(m_compiler.hasPreprocessor());
-	clang::Preprocessor& preproc = m_compiler.getPreprocessor();
-	preproc.getDiagnostics().setSuppressAllDiagnostics(true);
-	m_compiler.getDiagnosticClient().BeginSourceFile(m_compiler.getLangOpts(), &preproc);
-	ASSERT(m_compiler.hasASTContext());
-	reflector::visitor visitor(sc_mgr);
-	reflector::consumer consumer(visitor);
-	ParseAST(preproc, &consumer, m_compiler.getASTContext(), false, clang::TU_Complete, 0, true);
-	m_compiler.getDiagnosticClient().EndSourceFile();
-	if (visitor.has_reflected_class()) {
-		writer(m_output_file_name).write_reflected(visitor.get_reflected_classes());
-	}
-}
-
-int application::run()
-{
-	if (m_input_file_name.empty()) {
-		return 1;
-	}
-	parse_ast();
-	return 0;
-}
-
-void application::get_options(options& o) const
-{
-	definition d1("-i", "input file", requared);
-	o.add_option(d1);
-	definition d2("-o", "output file", optional);
-	o.add_option(d2);
-	definition d3("-h", "help", hidden);
-	o.add_option(d3);
-	definition d4("-v", "version", hidden);
-	o.add_option(d4);
-}
-
-bool application::parse_parameters(unsigned c, char const **v)
-{
-	ASSERT(0 != v);
-	if (1 == c) {
-		massenger::print("Usage: " + usage(v[0]));
-		return false;
-	}
-	options o;
-	get_options(o);
-	for (unsigned i = 1; i < c; i += 2) {
-		definition d;
-		if (!o.get_option(v[i], d)) {
-			massenger::print("Unknown option: " + std::string(v[i]));
-			return false;
-		}
-		if (d.is_hidden()) {
-			massenger::print(get_hidden_option_value(d.get_name()));
-			return false;
-		}
-		if (i + 1 == c) {
-			massenger::print("Incorect argument for option: " + std::string(v[i]));
-			return false;
-		}
-		o.set_value(v[i], v[i + 1]);
-	}
-	m_input_file_name = o.get_value("-i");
-	if (m_input_file_name.empty()) {
-		massenger::error("The input file must to provide");
-		return false;
-	}
-	if (!utils::exist_file(m_input_file_name)) {
-		massenger::error("The input file with name '" + m_input_file_name + "' does not exist");
-		return false;
-	}
-	m_output_file_name = o.get_value("-o");
-	if (m_output_file_name.empty()) {
-		m_output_file_name = utils::generate_out_file_name(m_input_file_name);
-	}
-	return true;
-}
-
-std::string application::get_hidden_option_value(const std::string& n) const
-{
-	if (n == "-h") {
-		return help();
-	}
-	ASSERT(n == "-v");
-	return version();
-}
-
-} // namespace reflector
-
-#endif // APPLICATION_HPP
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef APPLICATION_HPP
+#define APPLICATION_HPP
+
+#include "cache.hpp"
+#include "debug.hpp"
+#include "devirtualization.hpp"
+#include "generator.hpp"
+#include "messenger.hpp"
+#include "option.hpp"
+#include "precompiled_header.hpp"
+#include "profile.hpp"
+#include "selection.hpp"
+#include "server.hpp"
+#include "session.hpp"
+#include "stat_cache.hpp"
+#include "statistics.hpp"
+#include "thread_pool.hpp"
+#include "utils.hpp"
+
+#include <clang/Basic/VirtualFileSystem.h>
+#include <clang/Tooling/CompilationDatabase.h>
+#include <clang/Tooling/JSONCompilationDatabase.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <map>
+#include <memory>
+#include <numeric>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace reflector {
+
+// @class application
+class application
+{
+private:
+	typedef std::vector<job> jobs;
+	typedef std::vector<std::string> strings;
+	typedef std::vector<cache::entry::dependencies> dependencies;
+	typedef std::vector<strings> targets;
+	typedef std::vector<std::size_t> indices;
+	typedef std::map<int, std::string> watched_directories;
+	typedef std::vector<statistics> job_statistics;
+	typedef std::vector<model::unit> units;
+	typedef llvm::IntrusiveRefCntPtr<clang::vfs::InMemoryFileSystem> memory_file_system;
+public:
+	//@brief constructor
+	//@param s state of server which runs application for its request
+	application(int c, char const **v, session* s = 0);
+public:
+	//@brief Runs application.
+	//@return Exit code.
+	int run();
+
+	//@brief Gets application's name.
+	//@return name of application
+	static const std::string& get_name();
+
+	//@brief Gets application's description.
+	//@return description of application
+	static const std::string& get_description();
+private:
+	unsigned run_jobs(const indices&);
+
+	void report_statistics(const indices&, double) const;
+
+	void report_devirtualization() const;
+
+	int get_exit_code(unsigned) const;
+
+	int serve() const;
+
+	int watch();
+
+	void add_watches(int, watched_directories&) const;
+
+	static bool read_changes(int, const watched_directories&, std::set<std::string>&);
+
+	static std::string get_absolute(const std::string&);
+
+	static const std::string& get_standard_input_name();
+
+	bool load_standard_input(bool);
+
+	bool add_buffer(const std::string&, llvm::StringRef);
+
+	generator::file_system get_file_system(const generator::file_system&) const;
+
+	bool load_compile_commands(const std::string&, const strings&);
+
+	void add_job(const std::string&, const job::arguments&);
+
+	static void add_compile_arguments(const clang::tooling::CompileCommand&, job::arguments&);
+
+	static bool get_compile_value(const strings&, std::size_t&, const std::string&, std::string&);
+
+	static std::string make_absolute(const std::string&, const std::string&);
+
+	static std::string escape_dependency(const std::string&);
+
+	void write_depfile() const;
+
+	void get_options(options&) const;
+
+	bool parse_parameters(unsigned, char const **);
+
+	std::string get_hidden_option_value(const std::string&) const;
+
+	std::string usage(const char*) const;
+
+	std::string version() const;
+
+	static std::string get_build_id();
+
+	std::string help() const;
+private:
+	jobs m_jobs;
+	unsigned m_threads;
+	std::string m_cache_directory;
+	std::string m_depfile_name;
+	std::string m_precompiled_header;
+	std::string m_socket_name;
+	bool m_watch;
+	bool m_stats;
+	unsigned m_false_sharing;
+	bool m_devirtualization;
+	std::string m_stats_file_name;
+	profile m_profile;
+	session* m_session;
+	cache::ptr m_cache;
+	precompiled_header::ptr m_pch;
+	//@brief Files read from standard input, null if there are none.
+	memory_file_system m_buffers;
+	targets m_outs;
+	dependencies m_deps;
+	job_statistics m_statistics;
+	units m_units;
+}; // class application
+
+application::application(int c, char const **v, session* s)
+	: m_threads(0)
+	, m_watch(false)
+	, m_stats(false)
+	, m_false_sharing(0)
+	, m_devirtualization(false)
+	, m_session(s)
+{
+	parse_parameters(c, v);
+}
+
+const std::string& application::get_name()
+{
+	static const std::string name = "greflect";
+	return name;
+}
+
+const std::string& application::get_description()
+{
+	static const std::string desc = "Generate reflection for C++ programming language";
+	return desc;
+}
+
+std::string application::usage(const char* path) const
+{
+	return std::string(path ) + " -i <input file>[,<input file>...] | -c <compile_commands.json> | -S <socket>";
+}
+
+std::string application::version() const
+{
+	return "Version: a2017.06";
+}
+
+// @note: Cached models and precompiled headers are valid only for build of
+//        greflect which made them. Time of build changes with any rebuild,
+//        commit is given by GREFLECT_COMMIT of Makefile.
+std::string application::get_build_id()
+{
+#ifdef GREFLECT_COMMIT
+	const std::string commit = GREFLECT_COMMIT;
+#else
+	const std::string commit;
+#endif // GREFLECT_COMMIT
+	return std::string(model::get_magic()) + " " + commit + " " + __DATE__ + " " + __TIME__;
+}
+
+std::string application::help() const
+{
+	std::string h = get_name() + ":  " + get_description() + "\n";
+	h += "Options:\n";
+	options o;
+	get_options(o);
+	o.for_each_option(
+		[&h](const definition& d)
+		{
+			h += "  " + d.get_name() + ": " + d.get_description() +
+			(d.is_optional() || d.is_toggle() ? ": optional" : d.is_hidden() ? "" : ": requared") + "\n"; 
+		}
+	);
+	return h;
+}
+
+int application::run()
+{
+	if (!m_socket_name.empty()) {
+		return serve();
+	}
+	if (m_jobs.empty()) {
+		return 1;
+	}
+	if (!m_cache_directory.empty()) {
+		m_cache = std::make_shared<cache>(m_cache_directory, version() + " " + get_build_id());
+	}
+	if (!m_precompiled_header.empty()) {
+		m_pch = 0 == m_session ? std::make_shared<precompiled_header>(m_precompiled_header, m_cache)
+			: m_session->get_precompiled_header(m_precompiled_header, m_cache, m_cache_directory);
+	}
+	m_outs.assign(m_jobs.size(), strings());
+	m_deps.assign(m_jobs.size(), cache::entry::dependencies());
+	m_statistics.assign(m_jobs.size(), statistics());
+	m_units.assign(m_jobs.size(), model::unit());
+	indices all(m_jobs.size());
+	std::iota(all.begin(), all.end(), 0);
+	const unsigned failed = run_jobs(all);
+	if (0 == failed && !m_depfile_name.empty()) {
+		write_depfile();
+	}
+	if (m_watch) {
+		return watch();
+	}
+	return get_exit_code(failed);
+}
+
+// @note: False sharing has own code, so build check tells it from failure.
+int application::get_exit_code(unsigned failed) const
+{
+	if (0 != failed) {
+		return 1;
+	}
+	return 0 == m_false_sharing ? 0 : 2;
+}
+
+unsigned application::run_jobs(const indices& js)
+{
+	stat_cache::ptr stats = std::make_shared<stat_cache>();
+	std::atomic<unsigned> failed(0);
+	std::atomic<unsigned> shared(0);
+	const statistics::clock::time_point start = statistics::clock::now();
+	thread_pool(m_threads).for_each(js.size(),
+		[this, &js, &stats, &failed, &shared](unsigned, std::size_t n)
+		{
+			const std::size_t i = js[n];
+			const job& j = m_jobs[i];
+			m_outs[i].clear();
+			m_deps[i].clear();
+			m_statistics[i] = statistics();
+			m_units[i] = model::unit();
+			try {
+				const generator::file_system fs = get_file_system(generator::file_system(new stat_cache_file_system(stats)));
+				generator g(j, m_profile, fs, m_cache, m_pch);
+				g.run();
+				for (auto& o : g.get_outputs()) {
+					m_outs[i].push_back(o.file_name);
+				}
+				m_deps[i] = g.get_dependencies();
+				m_statistics[i] = g.get_statistics();
+				shared += g.get_false_sharing();
+				if (m_devirtualization) {
+					m_units[i] = g.get_unit();
+				}
+			} catch (const std::exception& e) {
+				massenger::error(j.input_file_name + ": " + e.what());
+				++failed;
+			} catch (...) {
+				massenger::error(j.input_file_name + ": Unhandled exception");
+				++failed;
+			}
+		}
+	);
+	if (m_stats || !m_stats_file_name.empty()) {
+		report_statistics(js, std::chrono::duration<double>(statistics::clock::now() - start).count());
+	}
+	m_false_sharing = shared;
+	if (m_devirtualization) {
+		report_devirtualization();
+	}
+	return failed;
+}
+
+// @note: Hierarchy spans all inputs, in watch mode unchanged inputs keep
+//        their classes from previous run.
+void application::report_devirtualization() const
+{
+	devirtualization d;
+	for (auto& u : m_units) {
+		d.add(u);
+	}
+	std::ostringstream out;
+	const unsigned count = d.dump(out);
+	massenger::print("Devirtualization candidates among " + std::to_string(d.get_class_count()) +
+			 " classes: " + std::to_string(count) + (0 == count ? "" : "\n" + out.str()));
+}
+
+void application::report_statistics(const indices& js, double wall) const
+{
+	statistics total;
+	for (auto i : js) {
+		total.merge(m_statistics[i]);
+	}
+	if (m_stats) {
+		std::ostringstream text;
+		total.dump_text(text, wall);
+		massenger::print(text.str());
+	}
+	if (m_stats_file_name.empty()) {
+		return;
+	}
+	std::ostringstream json;
+	json << "{\"wall_seconds\": " << statistics::format_seconds(wall)
+	     << ", \"peak_memory_kb\": " << statistics::get_peak_memory() << ",\n \"total\": ";
+	total.dump_json(json);
+	json << ",\n \"inputs\": [";
+	const char* separator = "\n  ";
+	for (auto i : js) {
+		if (!m_statistics[i].empty()) {
+			json << separator;
+			m_statistics[i].dump_json(json);
+			separator = ",\n  ";
+		}
+	}
+	json << "\n ]}\n";
+	writer(m_stats_file_name).write(json.str(), "statistics");
+}
+
+int application::serve() const
+{
+	session s;
+	return server(m_socket_name).run(
+		[&s](int c, char const **v)
+		{
+			return application(c, v, &s).run();
+		}
+	);
+}
+
+int application::watch()
+{
+	const int fd = ::inotify_init1(IN_CLOEXEC);
+	if (-1 == fd) {
+		massenger::error(std::string("Can not watch files: ") + std::strerror(errno));
+		return 1;
+	}
+	watched_directories directories;
+	for (;;) {
+		add_watches(fd, directories);
+		massenger::print("Watching inputs and their dependencies");
+		std::set<std::string> changed;
+		if (!read_changes(fd, directories, changed)) {
+			::close(fd);
+			return 1;
+		}
+		indices affected;
+		for (std::size_t i = 0; i < m_jobs.size(); ++i) {
+			bool is_affected = 0 != changed.count(get_absolute(m_jobs[i].input_file_name));
+			for (auto& d : m_deps[i]) {
+				is_affected = is_affected || 0 != changed.count(get_absolute(d.file_name));
+			}
+			if (is_affected) {
+				affected.push_back(i);
+			}
+		}
+		if (affected.empty()) {
+			continue;
+		}
+		run_jobs(affected);
+		if (!m_depfile_name.empty()) {
+			write_depfile();
+		}
+	}
+}
+
+void application::add_watches(int fd, watched_directories& directories) const
+{
+	std::set<std::string> names;
+	for (std::size_t i = 0; i < m_jobs.size(); ++i) {
+		names.insert(llvm::sys::path::parent_path(get_absolute(m_jobs[i].input_file_name)));
+		for (auto& d : m_deps[i]) {
+			names.insert(llvm::sys::path::parent_path(get_absolute(d.file_name)));
+		}
+	}
+	for (auto& n : names) {
+		// @note: Same directory gets same descriptor again.
+		const int wd = ::inotify_add_watch(fd, n.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (-1 != wd) {
+			directories[wd] = n;
+		}
+	}
+}
+
+bool application::read_changes(int fd, const watched_directories& directories, std::set<std::string>& changed)
+{
+	alignas(inotify_event) char buffer[4096];
+	// @note: Editors and build steps touch several files at once, changes
+	//        are gathered until 100 ms pass without new one.
+	for (int timeout = -1;; timeout = 100) {
+		pollfd p = { fd, POLLIN, 0 };
+		const int r = ::poll(&p, 1, timeout);
+		if (r < 0 && EINTR == errno) {
+			continue;
+		}
+		if (r < 0) {
+			massenger::error(std::string("Can not watch files: ") + std::strerror(errno));
+			return false;
+		}
+		if (0 == r) {
+			return true;
+		}
+		const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+		if (n <= 0) {
+			continue;
+		}
+		for (char* e = buffer; e < buffer + n;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(e);
+			watched_directories::const_iterator d = directories.find(event->wd);
+			if (d != directories.end() && 0 != event->len) {
+				llvm::SmallString<256> name(d->second);
+				llvm::sys::path::append(name, event->name);
+				changed.insert(name.str());
+			}
+			e += sizeof(inotify_event) + event->len;
+		}
+	}
+}
+
+std::string application::get_absolute(const std::string& file_name)
+{
+	if (file_name.empty()) {
+		return file_name;
+	}
+	llvm::SmallString<256> p(file_name);
+	llvm::sys::fs::make_absolute(p);
+	llvm::sys::path::remove_dots(p, true);
+	return p.str();
+}
+
+//@brief Gets name of input read from standard input, it is in working
+//       directory, as its includes are looked for there.
+const std::string& application::get_standard_input_name()
+{
+	static const std::string name = "stdin.hpp";
+	return name;
+}
+
+// @note: With --buffers standard input holds files, each as line
+//        '<size> <name>' followed by size bytes, otherwise it is the only
+//        input. Nothing of it is written to disk.
+bool application::load_standard_input(bool buffers)
+{
+	llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer> > in = llvm::MemoryBuffer::getSTDIN();
+	if (!in) {
+		massenger::error("Can not read standard input: " + in.getError().message());
+		return false;
+	}
+	m_buffers = new clang::vfs::InMemoryFileSystem;
+	m_buffers->setCurrentWorkingDirectory(get_absolute("."));
+	llvm::StringRef data = (*in)->getBuffer();
+	if (!buffers) {
+		return add_buffer(get_standard_input_name(), data);
+	}
+	while (!data.empty()) {
+		const std::size_t end = data.find('\n');
+		const llvm::StringRef header = data.substr(0, end);
+		const std::pair<llvm::StringRef, llvm::StringRef> h = header.split(' ');
+		std::size_t size = 0;
+		if (llvm::StringRef::npos == end || h.first.getAsInteger(10, size) || h.second.empty() ||
+		    data.size() - end - 1 < size) {
+			massenger::error("Incorect buffer on standard input: '" + header.str() + "'");
+			return false;
+		}
+		if (!add_buffer(h.second.str(), data.substr(end + 1, size))) {
+			return false;
+		}
+		data = data.substr(end + 1 + size);
+	}
+	return true;
+}
+
+bool application::add_buffer(const std::string& name, llvm::StringRef data)
+{
+	ASSERT(0 != m_buffers);
+	if (!m_buffers->addFile(get_absolute(name), 0, llvm::MemoryBuffer::getMemBufferCopy(data, name))) {
+		massenger::error("Buffer '" + name + "' is given twice");
+		return false;
+	}
+	return true;
+}
+
+//@brief Puts files of standard input over given file system.
+generator::file_system application::get_file_system(const generator::file_system& fs) const
+{
+	if (0 == m_buffers) {
+		return fs;
+	}
+	llvm::IntrusiveRefCntPtr<clang::vfs::OverlayFileSystem> overlay(new clang::vfs::OverlayFileSystem(fs));
+	overlay->pushOverlay(m_buffers);
+	return overlay;
+}
+
+std::string application::escape_dependency(const std::string& file_name)
+{
+	std::string r;
+	for (auto c : file_name) {
+		if (' ' == c || '#' == c) {
+			r += '\\';
+		} else if ('$' == c) {
+			r += '$';
+		}
+		r += c;
+	}
+	return r;
+}
+
+void application::write_depfile() const
+{
+	std::string data;
+	for (std::size_t i = 0; i < m_jobs.size(); ++i) {
+		if (m_outs[i].empty()) {
+			continue;
+		}
+		for (auto& o : m_outs[i]) {
+			data += escape_dependency(o) + " ";
+		}
+		data.back() = ':';
+		for (auto& d : m_deps[i]) {
+			data += " \\\n  " + escape_dependency(d.file_name);
+		}
+		data += "\n";
+	}
+	writer(m_depfile_name).write(data, "dependencies");
+}
+
+std::string application::make_absolute(const std::string& directory, const std::string& path)
+{
+	if (path.empty() || llvm::sys::path::is_absolute(path)) {
+		return path;
+	}
+	llvm::SmallString<256> p(directory);
+	llvm::sys::path::append(p, path);
+	return p.str();
+}
+
+// @note: Options which change header lookup and parsing are taken, those
+//        of driver are given as compiler (-cc1) expects them. Arguments
+//        passed to compiler through -Xclang are taken as own ones,
+//        -include-pch of build is skipped with its file, it is made by
+//        other compiler.
+void application::add_compile_arguments(const clang::tooling::CompileCommand& c, job::arguments& args)
+{
+	struct option
+	{
+		const char* name;
+		const char* compiler_name;
+		bool path;
+	};
+	static const option with_value[] = {
+		{ "-I", "-I", true },
+		{ "-isystem", "-isystem", true },
+		{ "-iquote", "-iquote", true },
+		{ "-idirafter", "-idirafter", true },
+		{ "-include", "-include", true },
+		{ "-isysroot", "-isysroot", true },
+		{ "--sysroot=", "-isysroot", true },
+		{ "--sysroot", "-isysroot", true },
+		{ "-D", "-D", false },
+		{ "-U", "-U", false },
+		{ "--target=", "-triple", false },
+		{ "-target", "-triple", false },
+		{ "-x", "-x", false }
+	};
+	static const char* const passed[] = { "-std=", "-stdlib=", "-nostdinc++", "-nobuiltininc" };
+	const strings& line = c.CommandLine;
+	for (std::size_t i = 1; i < line.size(); ++i) {
+		const std::string& a = line[i];
+		std::string value;
+		if ("-include-pch" == a) {
+			get_compile_value(line, i, a, value);
+			continue;
+		}
+		if ("-nostdinc" == a || "-nostdlibinc" == a) {
+			args.push_back("-nostdsysteminc");
+			if ("-nostdinc" == a) {
+				args.push_back("-nobuiltininc");
+			}
+			continue;
+		}
+		const char* const* p = std::find_if(std::begin(passed), std::end(passed),
+			[&a](const char* o)
+			{
+				const std::size_t size = std::strlen(o);
+				return 0 == a.compare(0, size, o) && ('=' == o[size - 1] || a.size() == size);
+			}
+		);
+		if (std::end(passed) != p) {
+			args.push_back(a);
+			continue;
+		}
+		for (auto& o : with_value) {
+			if (get_compile_value(line, i, o.name, value)) {
+				args.push_back(o.compiler_name);
+				args.push_back(o.path ? make_absolute(c.Directory, value) : value);
+				break;
+			}
+		}
+	}
+}
+
+//@brief Gets value of option given as 'option value' or 'optionvalue'.
+//       Joined value does not start with '-', as '-include-pch' is not
+//       '-include' of '-pch'.
+//@param i index of argument, moved to separate value
+bool application::get_compile_value(const strings& line, std::size_t& i, const std::string& option, std::string& value)
+{
+	const std::string& a = line[i];
+	if (option == a) {
+		if (i + 2 < line.size() && "-Xclang" == line[i + 1]) {
+			++i;
+		}
+		if (i + 1 < line.size()) {
+			value = line[++i];
+			return true;
+		}
+		return false;
+	}
+	if (a.size() <= option.size() || 0 != a.compare(0, option.size(), option) || '-' == a[option.size()]) {
+		return false;
+	}
+	value = a.substr(option.size());
+	return true;
+}
+
+bool application::load_compile_commands(const std::string& file_name, const strings& inputs)
+{
+	std::string error;
+	std::unique_ptr<clang::tooling::JSONCompilationDatabase> db =
+		clang::tooling::JSONCompilationDatabase::loadFromFile(file_name, error);
+	if (!db) {
+		massenger::error(error);
+		return false;
+	}
+	const std::vector<clang::tooling::CompileCommand> all = db->getAllCompileCommands();
+	if (all.empty()) {
+		massenger::error("No compile commands in '" + file_name + "'");
+		return false;
+	}
+	if (inputs.empty()) {
+		for (auto& c : all) {
+			job::arguments args;
+			add_compile_arguments(c, args);
+			add_job(make_absolute(c.Directory, c.Filename), args);
+		}
+		return true;
+	}
+	for (auto& i : inputs) {
+		// @note: Headers have no own entry, they take flags of the first one.
+		std::vector<clang::tooling::CompileCommand> own = db->getCompileCommands(i);
+		const clang::tooling::CompileCommand& c = own.empty() ? all.front() : own.front();
+		job::arguments args;
+		add_compile_arguments(c, args);
+		add_job(i, args);
+	}
+	return true;
+}
+
+void application::add_job(const std::string& input, const job::arguments& args)
+{
+	job j;
+	j.input_file_name = input;
+	j.output_file_name = utils::generate_out_file_name(input);
+	j.split = false;
+	j.source = false;
+	j.layout_report = false;
+	j.false_sharing = false;
+	j.stream = false;
+	j.threads = 1;
+	j.args = args;
+	m_jobs.push_back(j);
+}
+
+void application::get_options(options& o) const
+{
+	definition d1("-i", "input files separated by ',', '-' reads the only input from standard input", optional);
+	o.add_option(d1);
+	definition d2("-o", "output file, only with one input file, '-' writes standard output", optional);
+	o.add_option(d2);
+	definition d3("-h", "help", hidden);
+	o.add_option(d3);
+	definition d4("-v", "version", hidden);
+	o.add_option(d4);
+	definition d5("-p", "profile file with '<method> <calls>' lines, orders generated dispatch", optional);
+	o.add_option(d5);
+	definition d6("-m", "binary metadata file, see metadata_reader.hpp, only with one input file", optional);
+	o.add_option(d6);
+	definition d7("-c", "compile_commands.json, inputs and their flags, all its files if there is no -i", optional);
+	o.add_option(d7);
+	definition d8("-I", "include directories separated by ':'", optional);
+	o.add_option(d8);
+	definition d9("-j", "number of parallel jobs, or rendering threads of single input, 0 means number of hardware threads", optional, "0");
+	o.add_option(d9);
+	definition d10("-C", "cache directory, unchanged inputs are not parsed again", optional);
+	o.add_option(d10);
+	definition d11("-d", "Make/Ninja depfile with dependencies of outputs", optional);
+	o.add_option(d11);
+	definition d12("-s", "split output into header per type, output file includes all of them", toggle);
+	o.add_option(d12);
+	definition d13("-x", "write strings, tables and invoke bodies into <output>.cpp, headers only declare them", toggle);
+	o.add_option(d13);
+	definition d14("-P", "common header to precompile once and load before each input, or built '.pch'", optional);
+	o.add_option(d14);
+	definition d15("-S", "serve requests of greflect-client on Unix socket, keeping precompiled headers warm", optional);
+	o.add_option(d15);
+	definition d16("-w", "watch inputs and their dependencies, regenerate outputs of changed ones", toggle);
+	o.add_option(d16);
+	definition d17("-a", "reflect only types and members annotated with annotate(\"reflect\")", toggle);
+	o.add_option(d17);
+	definition d18("-e", "exclude list, qualified names of types and 'Type::member' names not to reflect", optional);
+	o.add_option(d18);
+	definition d19("--stats", "print times of setup, parse, traversal, extraction and emission, and counts", toggle);
+	o.add_option(d19);
+	definition d20("--stats-json", "write statistics of --stats per input and in total into JSON file", optional);
+	o.add_option(d20);
+	definition d21("--layout-report", "print offsets, padding and cache lines of reflected classes, and better field order", toggle);
+	o.add_option(d21);
+	definition d22("--false-sharing", "report atomics, locks and 'per_thread' fields sharing cache line, exit code 2 if any", toggle);
+	o.add_option(d22);
+	definition d23("--devirtualization", "report classes which could be final or lose virtual table and methods never overridden, across all inputs", toggle);
+	o.add_option(d23);
+	definition d24("--stream", "write classes as soon as they are parsed, memory does not grow with input; not with -C, -m, -s, -x and reports", toggle);
+	o.add_option(d24);
+	definition d25("--buffers", "read files from standard input, each as '<size> <name>' line and size bytes, compiler sees them over files on disk", toggle);
+	o.add_option(d25);
+}
+
+bool application::parse_parameters(unsigned c, char const **v)
+{
+	ASSERT(0 != v);
+	if (1 == c) {
+		massenger::print("Usage: " + usage(v[0]));
+		return false;
+	}
+	options o;
+	get_options(o);
+	for (unsigned i = 1; i < c; ++i) {
+		definition d;
+		if (!o.get_option(v[i], d)) {
+			massenger::print("Unknown option: " + std::string(v[i]));
+			return false;
+		}
+		if (d.is_hidden()) {
+			massenger::print(get_hidden_option_value(d.get_name()));
+			return false;
+		}
+		if (d.is_toggle()) {
+			o.set_value(v[i], "1");
+			continue;
+		}
+		if (i + 1 == c) {
+			massenger::print("Incorect argument for option: " + std::string(v[i]));
+			return false;
+		}
+		o.set_value(v[i], v[i + 1]);
+		++i;
+	}
+	if (0 != m_session && !(o.get_value("-S").empty() && o.get_value("-w").empty())) {
+		massenger::error("Options -S and -w can not be sent to server");
+		return false;
+	}
+	m_socket_name = o.get_value("-S");
+	if (!m_socket_name.empty()) {
+		return true;
+	}
+	m_watch = !o.get_value("-w").empty();
+	strings inputs;
+	utils::split(o.get_value("-i"), inputs, ",");
+	inputs.erase(std::remove(inputs.begin(), inputs.end(), std::string()), inputs.end());
+	const std::string& compile_commands = o.get_value("-c");
+	if (inputs.empty() && compile_commands.empty()) {
+		massenger::error("The input file must to provide");
+		return false;
+	}
+	const bool standard_input = inputs.end() != std::find_if(inputs.begin(), inputs.end(), utils::is_standard_stream);
+	const bool buffers = !o.get_value("--buffers").empty();
+	if (standard_input && (buffers || 1 != inputs.size() || !compile_commands.empty())) {
+		massenger::error("Input '-' can not be used with other inputs, -c and --buffers");
+		return false;
+	}
+	if ((standard_input || buffers) && (0 != m_session || m_watch || !o.get_value("-C").empty())) {
+		massenger::error("Standard input can not be sent to server, watched or cached with -C");
+		return false;
+	}
+	if ((standard_input || buffers) && !load_standard_input(buffers)) {
+		return false;
+	}
+	if (standard_input) {
+		inputs.front() = get_standard_input_name();
+	}
+	const generator::file_system fs = get_file_system(clang::vfs::getRealFileSystem());
+	for (auto& i : inputs) {
+		if (!utils::exist_file(*fs, i)) {
+			massenger::error("The input file with name '" + i + "' does not exist");
+			return false;
+		}
+	}
+	const std::string& threads = o.get_value("-j");
+	if (threads.empty() || std::string::npos != threads.find_first_not_of("0123456789")) {
+		massenger::error("Incorect number of jobs: '" + threads + "'");
+		return false;
+	}
+	m_threads = std::stoul(threads);
+	if (compile_commands.empty()) {
+		for (auto& i : inputs) {
+			add_job(i, job::arguments());
+		}
+	} else if (!load_compile_commands(compile_commands, inputs)) {
+		m_jobs.clear();
+		return false;
+	}
+	strings include_dirs;
+	utils::split(o.get_value("-I"), include_dirs, ":");
+	for (auto& d : include_dirs) {
+		if (d.empty()) {
+			continue;
+		}
+		for (auto& j : m_jobs) {
+			j.args.push_back("-I" + d);
+		}
+	}
+	const std::string& output_file_name = o.get_value("-o");
+	const std::string& metadata_file_name = o.get_value("-m");
+	if (1 != m_jobs.size() && !(output_file_name.empty() && metadata_file_name.empty())) {
+		massenger::error("Options -o and -m can be used only with one input file");
+		m_jobs.clear();
+		return false;
+	}
+	if (!output_file_name.empty()) {
+		m_jobs.front().output_file_name = output_file_name;
+	} else if (standard_input) {
+		m_jobs.front().output_file_name = "-";
+	}
+	if (!metadata_file_name.empty()) {
+		m_jobs.front().metadata_file_name = metadata_file_name;
+	}
+	const bool split = !o.get_value("-s").empty();
+	const bool source = !o.get_value("-x").empty();
+	const bool layout = !o.get_value("--layout-report").empty();
+	const bool sharing = !o.get_value("--false-sharing").empty();
+	const bool stream = !o.get_value("--stream").empty();
+	const bool standard_output = 1 == m_jobs.size() && utils::is_standard_stream(m_jobs.front().output_file_name);
+	if (standard_output && (split || source || !o.get_value("-d").empty() || 0 != m_session)) {
+		massenger::error("Output '-' can not be used with -s, -x and -d, or sent to server");
+		m_jobs.clear();
+		return false;
+	}
+	if (standard_output) {
+		// @note: Standard output carries only generated code.
+		massenger::redirect(&std::cerr);
+	}
+	if (stream && (split || source || layout || sharing || !metadata_file_name.empty() ||
+		       !o.get_value("-C").empty() || !o.get_value("--devirtualization").empty())) {
+		massenger::error("Option --stream can not be used with -C, -m, -s, -x, --layout-report, --false-sharing and --devirtualization");
+		m_jobs.clear();
+		return false;
+	}
+	std::shared_ptr<selection> select = std::make_shared<selection>();
+	select->set_annotated_only(!o.get_value("-a").empty());
+	const std::string& exclude_file_name = o.get_value("-e");
+	if (!exclude_file_name.empty()) {
+		select->load_exclude_list(exclude_file_name);
+	}
+	// @note: Many inputs already keep threads busy, only the single one
+	//       builds and renders its classes in parallel.
+	const unsigned class_threads = 1 == m_jobs.size() ? m_threads : 1;
+	for (auto& j : m_jobs) {
+		j.threads = class_threads;
+		j.split = split;
+		j.source = source;
+		j.layout_report = layout;
+		j.false_sharing = sharing;
+		j.stream = stream;
+		j.select = select;
+	}
+	// @note: Server keeps them between requests of different directories.
+	m_cache_directory = get_absolute(o.get_value("-C"));
+	m_depfile_name = o.get_value("-d");
+	m_precompiled_header = get_absolute(o.get_value("-P"));
+	m_stats = !o.get_value("--stats").empty();
+	m_devirtualization = !o.get_value("--devirtualization").empty();
+	m_stats_file_name = o.get_value("--stats-json");
+	const std::string& profile_file_name = o.get_value("-p");
+	if (!profile_file_name.empty()) {
+		m_profile.load(profile_file_name);
+	}
+	return true;
+}
+
+std::string application::get_hidden_option_value(const std::string& n) const
+{
+	if (n == "-h") {
+		return help();
+	}
+	ASSERT(n == "-v");
+	return version();
+}
+
+} // namespace reflector
+
+#endif // APPLICATION_HPP
@@ -0,0 +1,241 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MD5.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <ctime>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+namespace reflector {
+
+// @class cache
+// @brief Models of earlier parses, one file per key in cache directory.
+//        Key is digest of everything known before parsing: version and
+//        build of greflect, input and arguments. Entry lists digests of
+//        all files the parse has read, it is valid while all of them are
+//        unchanged.
+class cache
+{
+public:
+	typedef std::shared_ptr<cache> ptr;
+
+	// @struct dependency
+	struct dependency
+	{
+		std::string file_name;
+		std::string digest;
+		//@brief Size and modification time, digest is computed only
+		//       if they differ. Zero time means always compute.
+		long long size;
+		long long time;
+	}; // struct dependency
+
+	// @struct entry
+	struct entry
+	{
+		typedef std::vector<dependency> dependencies;
+
+		dependencies files;
+		//@brief Serialized model, see model.hpp.
+		std::string model;
+	}; // struct entry
+
+	typedef std::vector<std::string> strings;
+public:
+	cache(const std::string& directory, const std::string& version)
+		: m_directory(directory)
+		, m_version(version)
+	{
+		const std::error_code error_info = llvm::sys::fs::create_directories(directory);
+		if (error_info) {
+			throw std::runtime_error("Can not create cache directory '" + directory + "': " +
+						 error_info.message());
+		}
+	}
+
+	static std::string get_digest(const llvm::StringRef& data)
+	{
+		llvm::MD5 h;
+		h.update(data);
+		llvm::MD5::MD5Result r;
+		h.final(r);
+		llvm::SmallString<32> s;
+		llvm::MD5::stringifyResult(r, s);
+		return s.str();
+	}
+
+	//@return false if file can not be read.
+	static bool get_file_digest(const std::string& file_name, std::string& digest)
+	{
+		llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer> > b = llvm::MemoryBuffer::getFile(file_name);
+		if (!b) {
+			return false;
+		}
+		digest = get_digest((*b)->getBuffer());
+		return true;
+	}
+
+	std::string get_key(const strings& parts) const
+	{
+		std::string key = "greflect " + m_version;
+		for (auto& p : parts) {
+			key += '\0';
+			key += p;
+		}
+		return get_digest(key);
+	}
+
+	//@brief Finds entry which dependencies are unchanged.
+	bool find(const std::string& key, entry& e) const
+	{
+		llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer> > b = llvm::MemoryBuffer::getFile(get_file_name(key));
+		if (!b || !parse((*b)->getBuffer(), e)) {
+			return false;
+		}
+		for (auto& d : e.files) {
+			if (!is_unchanged(d)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//@brief Stores entry, digests of its files are computed here.
+	//@param start time before parsing, files modified since then are
+	//       checked by digest on each lookup.
+	void store(const std::string& key, entry& e, std::time_t start) const
+	{
+		for (auto& d : e.files) {
+			if (!update(d, start)) {
+				return;
+			}
+		}
+		std::string data;
+		serialize(e, data);
+		const std::string file_name = get_file_name(key);
+		int fd = -1;
+		llvm::SmallString<256> temp;
+		if (llvm::sys::fs::createUniqueFile(file_name + "-%%%%%%%%.tmp", fd, temp)) {
+			return;
+		}
+		{
+			llvm::raw_fd_ostream out(fd, true);
+			out << data;
+		}
+		if (llvm::sys::fs::rename(temp, file_name)) {
+			llvm::sys::fs::remove(temp);
+		}
+	}
+
+	//@brief Gets file of given key in cache directory.
+	std::string get_file_name(const std::string& key, const std::string& extension = ".greflect") const
+	{
+		llvm::SmallString<256> p(m_directory);
+		llvm::sys::path::append(p, key + extension);
+		return p.str();
+	}
+
+	//@brief Sets digest, size and time of dependency to current ones.
+	//@param start see store
+	static bool update(dependency& d, std::time_t start)
+	{
+		struct stat st;
+		if (0 != ::stat(d.file_name.c_str(), &st) || !get_file_digest(d.file_name, d.digest)) {
+			return false;
+		}
+		d.size = st.st_size;
+		d.time = st.st_mtime < start ? st.st_mtime : 0;
+		return true;
+	}
+
+	static bool is_unchanged(const dependency& d)
+	{
+		struct stat st;
+		if (0 != ::stat(d.file_name.c_str(), &st)) {
+			return false;
+		}
+		if (0 != d.time && d.time == st.st_mtime && d.size == st.st_size) {
+			return true;
+		}
+		std::string digest;
+		return get_file_digest(d.file_name, digest) && digest == d.digest;
+	}
+
+private:
+
+	static const char* get_magic()
+	{
+		return "greflect cache 3";
+	}
+
+	//@brief Entry file: magic line, number of files, one
+	//       "<digest> <size> <time> <file>" line per file, then size and
+	//       bytes of model.
+	static void serialize(const entry& e, std::string& data)
+	{
+		std::ostringstream out;
+		out << get_magic() << "\n" << e.files.size() << "\n";
+		for (auto& d : e.files) {
+			out << d.digest << " " << d.size << " " << d.time << " " << d.file_name << "\n";
+		}
+		out << e.model.size() << "\n" << e.model;
+		data = out.str();
+	}
+
+	static bool parse(const llvm::StringRef& data, entry& e)
+	{
+		std::istringstream in(data.str());
+		std::string line;
+		std::size_t count = 0;
+		if (!std::getline(in, line) || line != get_magic() || !(in >> count)) {
+			return false;
+		}
+		e.files.resize(count);
+		for (auto& d : e.files) {
+			if (!(in >> d.digest >> d.size >> d.time) || ' ' != in.get() ||
+			    !std::getline(in, d.file_name)) {
+				return false;
+			}
+		}
+		return read_block(in, e.model);
+	}
+
+	static bool read_block(std::istream& in, std::string& block)
+	{
+		std::size_t size = 0;
+		if (!(in >> size) || '\n' != in.get()) {
+			return false;
+		}
+		block.resize(size);
+		return 0 == size || in.read(&block[0], size);
+	}
+
+private:
+	std::string m_directory;
+	std::string m_version;
+}; // class cache
+
+} // namespace reflector
+
+#endif // CACHE_HPP
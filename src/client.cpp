@@ -0,0 +1,122 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+// @note: greflect-client [-S <socket>] <greflect options>
+//        Sends options to server started by 'greflect -S <socket>' and
+//        prints its messages, see server.hpp for protocol. Socket is taken
+//        from GREFLECT_SOCKET without -S. Depends on nothing but libc, so
+//        it starts fast.
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <limits.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace {
+
+bool send_all(int fd, const std::string& data)
+{
+	std::string::size_type written = 0;
+	while (written < data.size()) {
+		const ssize_t n = ::send(fd, data.data() + written, data.size() - written, MSG_NOSIGNAL);
+		if (n < 0 && EINTR == errno) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		written += n;
+	}
+	return true;
+}
+
+bool receive_all(int fd, std::string& data)
+{
+	char buffer[4096];
+	for (;;) {
+		const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+		if (0 == n) {
+			return true;
+		}
+		if (n < 0) {
+			if (EINTR == errno) {
+				continue;
+			}
+			return false;
+		}
+		data.append(buffer, n);
+	}
+}
+
+int connect_to(const std::string& socket_name)
+{
+	sockaddr_un address;
+	std::memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (socket_name.size() >= sizeof(address.sun_path)) {
+		return -1;
+	}
+	std::strcpy(address.sun_path, socket_name.c_str());
+	const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+	if (-1 != fd && 0 != ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address))) {
+		::close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+} // unnamed namespace
+
+int main(int argc, char const **argv)
+{
+	int first = 1;
+	const char* env = std::getenv("GREFLECT_SOCKET");
+	std::string socket_name = 0 == env ? "" : env;
+	if (3 <= argc && std::string("-S") == argv[1]) {
+		socket_name = argv[2];
+		first = 3;
+	}
+	if (socket_name.empty()) {
+		std::cerr << "Error: Socket of greflect server must to provide by -S or GREFLECT_SOCKET" << std::endl;
+		return 1;
+	}
+	char directory[PATH_MAX];
+	if (0 == ::getcwd(directory, sizeof(directory))) {
+		std::cerr << "Error: Can not get working directory: " << std::strerror(errno) << std::endl;
+		return 1;
+	}
+	std::string request(directory);
+	request += '\0';
+	for (int i = first; i < argc; ++i) {
+		request += argv[i];
+		request += '\0';
+	}
+	const int fd = connect_to(socket_name);
+	if (-1 == fd) {
+		std::cerr << "Error: Can not connect to greflect server on '" << socket_name << "'" << std::endl;
+		return 1;
+	}
+	std::string reply;
+	const bool ok = send_all(fd, request) && 0 == ::shutdown(fd, SHUT_WR) && receive_all(fd, reply);
+	::close(fd);
+	const std::string::size_type e = reply.find('\n');
+	if (!ok || std::string::npos == e) {
+		std::cerr << "Error: Connection to greflect server is broken" << std::endl;
+		return 1;
+	}
+	std::cout << reply.substr(e + 1);
+	return std::atoi(reply.substr(0, e).c_str());
+}
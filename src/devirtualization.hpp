@@ -0,0 +1,108 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef DEVIRTUALIZATION_HPP
+#define DEVIRTUALIZATION_HPP
+
+#include "model.hpp"
+
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+
+namespace reflector {
+
+// @class devirtualization
+// @brief Builds hierarchy of reflected classes of all inputs and finds
+//        virtual dispatch which could be avoided. Classes out of inputs
+//        are not known, candidates hold if none of them derives from
+//        reflected class.
+class devirtualization
+{
+private:
+	typedef std::map<std::string, const model::record*> classes;
+	typedef std::set<std::string> names;
+public:
+	//@brief Adds classes of one input, unit must outlive dump.
+	void add(const model::unit& u)
+	{
+		for (auto& c : u.classes) {
+			m_classes.insert(std::make_pair(c.qualified_name, &c));
+			for (auto& b : c.bases) {
+				m_derived.insert(b.qualified_name);
+			}
+			for (auto& v : c.virtual_methods) {
+				m_overridden.insert(v.overrides.begin(), v.overrides.end());
+			}
+		}
+	}
+
+	//@brief Writes candidates in order of class names.
+	//@return Number of candidates.
+	unsigned dump(std::ostream& out) const
+	{
+		unsigned count = 0;
+		for (auto& i : m_classes) {
+			const model::record& c = *i.second;
+			if (!c.has(model::trait_polymorphic)) {
+				continue;
+			}
+			if (0 == m_derived.count(c.qualified_name)) {
+				count += dump_leaf(out, c);
+				continue;
+			}
+			for (auto& v : c.virtual_methods) {
+				if (v.is_pure || 0 != m_overridden.count(c.qualified_name + "::" + v.signature)) {
+					continue;
+				}
+				out << "    " << c.qualified_name << "::" << v.signature << ": never overridden, could be "
+				    << (v.overrides.empty() ? "non virtual\n" : "final\n");
+				++count;
+			}
+		}
+		return count;
+	}
+
+	std::size_t get_class_count() const
+	{
+		return m_classes.size();
+	}
+
+private:
+	//@brief Writes candidate for class which nothing derives from.
+	static unsigned dump_leaf(std::ostream& out, const model::record& c)
+	{
+		if (c.has(model::trait_abstract)) {
+			return 0;
+		}
+		if (!c.has(model::trait_polymorphic_base) && 0 == c.num_virtual_bases) {
+			out << "    " << c.qualified_name << ": virtual table could be removed, "
+			    << "nothing derives from it and it has no polymorphic base\n";
+			return 1;
+		}
+		if (c.has(model::trait_final)) {
+			return 0;
+		}
+		out << "    " << c.qualified_name << ": could be final, nothing derives from it\n";
+		return 1;
+	}
+
+private:
+	classes m_classes;
+	//@brief Qualified names of classes which something derives from.
+	names m_derived;
+	//@brief Overridden methods as '<qualified class name>::<signature>'.
+	names m_overridden;
+}; // class devirtualization
+
+} // namespace reflector
+
+#endif // DEVIRTUALIZATION_HPP
@@ -0,0 +1,433 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef EXTRACTOR_HPP
+#define EXTRACTOR_HPP
+
+#include "debug.hpp"
+#include "metadata_format.hpp"
+#include "model.hpp"
+#include "selection.hpp"
+#include "utils.hpp"
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Attr.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclCXX.h>
+#include <clang/AST/DeclTemplate.h>
+#include <clang/AST/PrettyPrinter.h>
+#include <clang/AST/RecordLayout.h>
+#include <clang/AST/Type.h>
+#include <clang/Basic/TargetInfo.h>
+#include <clang/Basic/Specifiers.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace reflector {
+
+// @class extractor
+// @brief Extracts model of reflected types from AST, the only place where
+//        outputs meet clang. One extractor serves one translation unit.
+class extractor
+{
+private:
+	typedef std::unordered_map<void*, std::string> type_names;
+public:
+	//@param k counts members left out by s
+	extractor(const selection& s, selection::skipped& k)
+		: m_selection(s)
+		, m_skipped(k)
+		, m_context(0)
+	{
+	}
+
+	model::record extract(const clang::CXXRecordDecl* d)
+	{
+		ASSERT(0 != d);
+		ASSERT(d->isClass() || d->isStruct() || d->isUnion());
+		ASSERT(d->hasDefinition());
+		const clang::ASTContext& c = d->getASTContext();
+		m_context = &c;
+		const clang::ASTRecordLayout& layout = c.getASTRecordLayout(d);
+		model::record r;
+		r.kind = d->getKindName().str();
+		r.name = d->getNameAsString() + get_template_arguments(d);
+		r.qualified_name = get_qualified_name(d);
+		r.type_name = utils::get_rtti_name(d);
+		const clang::ClassTemplateSpecializationDecl* s = clang::dyn_cast<clang::ClassTemplateSpecializationDecl>(d);
+		if (0 != s && !s->isExplicitSpecialization()) {
+			r.template_name = s->getSpecializedTemplate()->getQualifiedNameAsString();
+			get_template_parameters(s->getSpecializedTemplate(), r.template_parameters, r.template_arguments);
+		}
+		r.size = layout.getSize().getQuantity();
+		r.alignment = layout.getAlignment().getQuantity();
+		r.num_virtual_bases = d->getNumVBases();
+		r.traits = get_traits(d);
+		for (auto& b : d->bases()) {
+			model::base mb;
+			// @note: Base is named as type of reflect, qualified and without
+			//        tag keyword, so struct, union and template bases are
+			//        found by is_derived_from.
+			const clang::CXXRecordDecl* bd = b.getType()->getAsCXXRecordDecl();
+			mb.name = 0 == bd ? get_type_name(b.getType()) : get_qualified_name(bd);
+			mb.qualified_name = mb.name;
+			mb.access = get_access(b.getAccessSpecifier());
+			mb.is_virtual = b.isVirtual();
+			r.bases.push_back(mb);
+		}
+		const bool annotated = selection::has_annotated_members(d);
+		// @note: Members of all instantiations are selected by name of template.
+		const std::string selected_name = d->getQualifiedNameAsString();
+		for (auto m : d->methods()) {
+			ASSERT(0 != m);
+			if (m->isVirtual() && !clang::isa<clang::CXXDestructorDecl>(m)) {
+				r.virtual_methods.push_back(extract_virtual(m));
+			}
+			if (!supported(m)) {
+				continue;
+			}
+			if (m_selection.is_selected_member(m, selected_name, annotated)) {
+				r.methods.push_back(extract(m));
+			} else {
+				++m_skipped.methods;
+			}
+		}
+		for (auto f : d->fields()) {
+			r.fields.push_back(extract(f, layout));
+			r.fields.back().is_selected = m_selection.is_selected_member(f, selected_name, annotated);
+			if (!r.fields.back().is_selected) {
+				++m_skipped.fields;
+			}
+		}
+		get_subobjects(d, layout, r.subobjects);
+		return r;
+	}
+
+	model::enumeration extract(const clang::EnumDecl* d) const
+	{
+		ASSERT(0 != d);
+		ASSERT(d->isCompleteDefinition());
+		model::enumeration e;
+		e.name = d->getNameAsString();
+		e.qualified_name = d->getQualifiedNameAsString();
+		e.type_name = utils::get_rtti_name(d);
+		const bool is_signed = d->getIntegerType()->isSignedIntegerOrEnumerationType();
+		for (auto i : d->enumerators()) {
+			const llvm::APSInt& v = i->getInitVal();
+			e.values.push_back(model::enumeration::enumerator(
+				is_signed ? v.getSExtValue() : static_cast<long long>(v.getZExtValue()), i->getNameAsString()));
+		}
+		return e;
+	}
+
+private:
+	static bool supported(const clang::CXXMethodDecl* m)
+	{
+		ASSERT(0 != m);
+		return !m->isStatic() && m->isUserProvided() && clang::Decl::Kind::CXXMethod == m->getKind() &&
+	                m->getAccess() == clang::AccessSpecifier::AS_public && !m->isDefaulted() &&
+	               !m->isCopyAssignmentOperator() && !m->isMoveAssignmentOperator();
+	}
+
+	model::method extract(const clang::CXXMethodDecl* m)
+	{
+		model::method r;
+		r.name = m->getNameAsString();
+		r.return_type = get_type_name(m->getReturnType());
+		for (auto p : m->parameters()) {
+			r.param_types.push_back(get_type_name(p->getType()));
+		}
+		r.is_const = m->isConst();
+		return r;
+	}
+
+	model::virtual_method extract_virtual(const clang::CXXMethodDecl* m)
+	{
+		model::virtual_method r;
+		r.signature = get_signature(m);
+		r.is_pure = m->isPure();
+		for (auto o = m->begin_overridden_methods(); o != m->end_overridden_methods(); ++o) {
+			r.overrides.push_back(get_qualified_name((*o)->getParent()) + "::" + get_signature(*o));
+		}
+		return r;
+	}
+
+	//@brief Gets signature which identifies virtual method across inputs.
+	std::string get_signature(const clang::CXXMethodDecl* m)
+	{
+		std::string s = m->getNameAsString() + "(";
+		for (unsigned i = 0; i < m->getNumParams(); ++i) {
+			s += (0 == i ? "" : ", ") + get_type_name(m->getParamDecl(i)->getType());
+		}
+		return s + (m->isConst() ? ") const" : ")");
+	}
+
+	model::field extract(const clang::FieldDecl* f, const clang::ASTRecordLayout& layout)
+	{
+		const clang::ASTContext& c = f->getASTContext();
+		const std::uint64_t offset = layout.getFieldOffset(f->getFieldIndex());
+		model::field r;
+		r.name = f->getNameAsString();
+		r.type = get_type_name(f->getType());
+		r.access = get_access(f->getAccess());
+		r.is_bit_field = f->isBitField();
+		r.offset = c.toCharUnitsFromBits(offset).getQuantity();
+		r.alignment = c.getTypeAlignInChars(f->getType()).getQuantity();
+		r.size = r.is_bit_field ? (f->getBitWidthValue(c) + offset % 8 + 7) / 8
+					: c.getTypeSizeInChars(f->getType()).getQuantity();
+		r.is_hot = selection::has_annotation(f, "hot");
+		r.sync = get_sync_kind(f);
+		return r;
+	}
+
+	//@brief Recognizes atomics and locks of standard library and POSIX,
+	//       and arrays of them. Members of nested classes are not looked at.
+	static model::sync_kind get_sync_kind(const clang::FieldDecl* f)
+	{
+		static const char* const std_atomics[] = { "atomic", "atomic_flag" };
+		static const char* const std_locks[] = {
+			"mutex", "recursive_mutex", "timed_mutex", "recursive_timed_mutex",
+			"shared_mutex", "shared_timed_mutex", "condition_variable", "condition_variable_any"
+		};
+		static const char* const posix_locks[] = {
+			"pthread_mutex_t", "pthread_rwlock_t", "pthread_spinlock_t", "pthread_cond_t"
+		};
+		if (selection::has_annotation(f, "per_thread")) {
+			return model::sync_per_thread;
+		}
+		const clang::QualType t = f->getASTContext().getBaseElementType(f->getType());
+		for (const clang::TypedefType* td = t->getAs<clang::TypedefType>(); 0 != td;
+		     td = td->getDecl()->getUnderlyingType()->getAs<clang::TypedefType>()) {
+			if (is_one_of(td->getDecl()->getName(), posix_locks)) {
+				return model::sync_lock;
+			}
+		}
+		if (t->isAtomicType()) {
+			return model::sync_atomic;
+		}
+		const clang::CXXRecordDecl* d = t->getAsCXXRecordDecl();
+		if (0 == d || !d->isInStdNamespace() || 0 == d->getIdentifier()) {
+			return model::sync_none;
+		}
+		return is_one_of(d->getName(), std_atomics) ? model::sync_atomic :
+		       is_one_of(d->getName(), std_locks) ? model::sync_lock : model::sync_none;
+	}
+
+	template <std::size_t N>
+	static bool is_one_of(llvm::StringRef name, const char* const (&names)[N])
+	{
+		for (auto n : names) {
+			if (name == n) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	//@brief Gets pointer to virtual table and non empty bases. Base takes
+	//       its size without virtual bases, they are separate subobjects.
+	void get_subobjects(const clang::CXXRecordDecl* d, const clang::ASTRecordLayout& layout,
+			    model::record::subobjects_type& subobjects)
+	{
+		const clang::ASTContext& c = d->getASTContext();
+		if (layout.hasOwnVFPtr()) {
+			model::subobject o;
+			o.name = "vptr";
+			o.offset = 0;
+			o.size = c.toCharUnitsFromBits(c.getTargetInfo().getPointerWidth(0)).getQuantity();
+			subobjects.push_back(o);
+		}
+		for (auto& b : d->bases()) {
+			const clang::CXXRecordDecl* bd = b.getType()->getAsCXXRecordDecl();
+			if (b.isVirtual() || 0 == bd || bd->isEmpty()) {
+				continue;
+			}
+			model::subobject o;
+			o.name = "base " + get_type_name(b.getType());
+			o.offset = layout.getBaseClassOffset(bd).getQuantity();
+			o.size = c.getASTRecordLayout(bd).getNonVirtualSize().getQuantity();
+			subobjects.push_back(o);
+		}
+		for (auto& b : d->vbases()) {
+			const clang::CXXRecordDecl* bd = b.getType()->getAsCXXRecordDecl();
+			if (0 == bd || bd->isEmpty()) {
+				continue;
+			}
+			model::subobject o;
+			o.name = "virtual base " + get_type_name(b.getType());
+			o.offset = layout.getVBaseClassOffset(bd).getQuantity();
+			o.size = c.getASTRecordLayout(bd).getNonVirtualSize().getQuantity();
+			subobjects.push_back(o);
+		}
+		std::stable_sort(subobjects.begin(), subobjects.end(),
+			[](const model::subobject& o1, const model::subobject& o2)
+			{
+				return o1.offset < o2.offset;
+			}
+		);
+	}
+
+	//@brief Gets qualified name, with arguments of template specialization.
+	std::string get_qualified_name(const clang::CXXRecordDecl* d)
+	{
+		return d->getQualifiedNameAsString() + get_template_arguments(d);
+	}
+
+	//@brief Gets "<arguments>" of template specialization, or empty string.
+	std::string get_template_arguments(const clang::CXXRecordDecl* d)
+	{
+		const clang::ClassTemplateSpecializationDecl* s = clang::dyn_cast<clang::ClassTemplateSpecializationDecl>(d);
+		if (0 == s) {
+			return std::string();
+		}
+		std::string arguments;
+		llvm::raw_string_ostream out(arguments);
+		clang::TemplateSpecializationType::PrintTemplateArgumentList(out, s->getTemplateArgs().asArray(), get_policy());
+		return out.str();
+	}
+
+	//@brief Writes template parameters without defaults, naming unnamed
+	//       ones, and them as arguments. Template template parameters are
+	//       not written, both stay empty.
+	void get_template_parameters(const clang::ClassTemplateDecl* t, std::string& parameters, std::string& arguments)
+	{
+		const clang::TemplateParameterList* ps = t->getTemplateParameters();
+		std::string ps_text;
+		std::string as_text;
+		for (unsigned i = 0; i < ps->size(); ++i) {
+			const clang::NamedDecl* p = ps->getParam(i);
+			std::string name = p->getNameAsString();
+			if (name.empty()) {
+				name = "P" + std::to_string(i);
+			}
+			bool pack = false;
+			std::string parameter;
+			if (const clang::TemplateTypeParmDecl* tp = clang::dyn_cast<clang::TemplateTypeParmDecl>(p)) {
+				parameter = "typename";
+				pack = tp->isParameterPack();
+			} else if (const clang::NonTypeTemplateParmDecl* np = clang::dyn_cast<clang::NonTypeTemplateParmDecl>(p)) {
+				if (np->isPackExpansion()) {
+					return;
+				}
+				parameter = get_type_name(np->getType());
+				pack = np->isParameterPack();
+			} else {
+				return;
+			}
+			const char* separator = 0 == i ? "" : ", ";
+			ps_text.append(separator).append(parameter).append(pack ? "... " : " ").append(name);
+			as_text.append(separator).append(name).append(pack ? "..." : "");
+		}
+		parameters = ps_text;
+		arguments = as_text;
+	}
+
+	const clang::PrintingPolicy& get_policy()
+	{
+		if (0 == m_policy) {
+			m_policy.reset(new clang::PrintingPolicy(m_context->getPrintingPolicy()));
+			m_policy->Bool = true;
+			m_policy->SuppressTagKeyword = true;
+		}
+		return *m_policy;
+	}
+
+	//@brief Prints type as written, with 'bool' and without tag keywords.
+	//       Each type is printed once, methods of the same signature only
+	//       look it up.
+	const std::string& get_type_name(const clang::QualType& t)
+	{
+		std::pair<type_names::iterator, bool> i = m_type_names.insert(std::make_pair(t.getAsOpaquePtr(), std::string()));
+		if (i.second) {
+			i.first->second = t.getAsString(get_policy());
+		}
+		return i.first->second;
+	}
+
+	static metadata::access get_access(clang::AccessSpecifier a)
+	{
+		return static_cast<metadata::access>(a);
+	}
+
+	static std::uint32_t get_traits(const clang::CXXRecordDecl* d)
+	{
+		std::uint32_t t = 0;
+		t |= d->isAbstract() ? model::trait_abstract : 0;
+		t |= d->isPolymorphic() ? model::trait_polymorphic : 0;
+		t |= d->isAggregate() ? model::trait_aggregate : 0;
+		t |= d->isUnion() ? model::trait_union : 0;
+		t |= d->isEmpty() ? model::trait_empty : 0;
+		t |= d->isTrivial() ? model::trait_trivial : 0;
+		t |= d->isTriviallyCopyable() ? model::trait_trivially_copyable : 0;
+		t |= d->isStandardLayout() ? model::trait_standard_layout : 0;
+		t |= d->isPOD() ? model::trait_pod : 0;
+		t |= d->hasDefaultConstructor() ? model::trait_default_constructor : 0;
+		t |= d->hasAnyDependentBases() ? model::trait_any_dependent_bases : 0;
+		t |= d->hasFriends() ? model::trait_friends : 0;
+		t |= d->hasUserDeclaredConstructor() ? model::trait_user_declared_constructor : 0;
+		t |= d->hasUserDeclaredCopyAssignment() ? model::trait_user_declared_copy_assignment : 0;
+		t |= d->hasUserDeclaredDestructor() ? model::trait_user_declared_destructor : 0;
+		t |= d->hasUserProvidedDefaultConstructor() ? model::trait_user_provided_default_constructor : 0;
+		t |= d->isTemplateDecl() ? model::trait_template_decl : 0;
+		t |= has_unique_representation(d) ? model::trait_unique_representation : 0;
+		t |= d->hasAttr<clang::FinalAttr>() ? model::trait_final : 0;
+		t |= clang::isa<clang::ClassTemplateSpecializationDecl>(d) ? model::trait_template_specialization : 0;
+		for (auto& b : d->bases()) {
+			const clang::CXXRecordDecl* bd = b.getType()->getAsCXXRecordDecl();
+			t |= 0 != bd && bd->isPolymorphic() ? model::trait_polymorphic_base : 0;
+		}
+		return t;
+	}
+
+	static bool has_unique_representation(const clang::QualType& t, const clang::ASTContext& c)
+	{
+		const clang::QualType e = c.getBaseElementType(t.getCanonicalType());
+		if (e->isIntegralOrEnumerationType() || e->isPointerType()) {
+			return true;
+		}
+		const clang::CXXRecordDecl* d = e->getAsCXXRecordDecl();
+		return 0 != d && has_unique_representation(d);
+	}
+
+	//@brief Checks that equal objects have equal bytes,
+	//       i.e. object can be compared with memcmp.
+	static bool has_unique_representation(const clang::CXXRecordDecl* d)
+	{
+		ASSERT(0 != d);
+		if (!d->hasDefinition() || d->isUnion() || d->isPolymorphic() ||
+		    !d->isTriviallyCopyable() || 0 != d->getNumBases()) {
+			return false;
+		}
+		const clang::ASTContext& c = d->getASTContext();
+		long long size = 0;
+		for (auto f : d->fields()) {
+			if (f->isBitField() || !has_unique_representation(f->getType(), c)) {
+				return false;
+			}
+			size += c.getTypeSizeInChars(f->getType()).getQuantity();
+		}
+		return size == c.getASTRecordLayout(d).getSize().getQuantity();
+	}
+
+private:
+	const selection& m_selection;
+	selection::skipped& m_skipped;
+	const clang::ASTContext* m_context;
+	std::unique_ptr<clang::PrintingPolicy> m_policy;
+	type_names m_type_names;
+}; // class extractor
+
+} // namespace reflector
+
+#endif // EXTRACTOR_HPP
@@ -0,0 +1,106 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef FALSE_SHARING_HPP
+#define FALSE_SHARING_HPP
+
+#include "layout_report.hpp"
+#include "model.hpp"
+
+#include <algorithm>
+#include <ostream>
+#include <vector>
+
+namespace reflector {
+
+// @class false_sharing
+// @brief Finds atomics, locks and per thread fields of one class which
+//        share cache line, so threads writing them invalidate line of
+//        each other. When class is aligned to cache line, lines are known
+//        from offsets, otherwise fields closer than line may share it.
+//        Fields left out by selection are checked too, they share lines
+//        with reflected ones all the same.
+class false_sharing
+{
+private:
+	typedef std::vector<const model::field*> fields;
+public:
+	explicit false_sharing(std::ostream& out)
+		: m_out(out)
+		, m_count(0)
+	{
+	}
+
+	//@brief Gets number of found pairs.
+	unsigned get_count() const
+	{
+		return m_count;
+	}
+
+	void check(const model::record& r)
+	{
+		fields hot;
+		for (auto& f : r.fields) {
+			if (model::sync_none != f.sync) {
+				hot.push_back(&f);
+			}
+		}
+		const unsigned line = layout_report::cache_line_size();
+		const bool aligned = 0 == r.alignment % line;
+		bool first = true;
+		for (std::size_t i = 0; i < hot.size(); ++i) {
+			for (std::size_t j = i + 1; j < hot.size(); ++j) {
+				const model::field* f1 = hot[i]->offset <= hot[j]->offset ? hot[i] : hot[j];
+				const model::field* f2 = f1 == hot[i] ? hot[j] : hot[i];
+				const unsigned end = f1->offset + std::max(1u, f1->size);
+				const bool shared = aligned ? f2->offset / line <= (end - 1) / line : f2->offset < end - 1 + line;
+				if (!shared) {
+					continue;
+				}
+				if (first) {
+					m_out << r.kind << " " << r.qualified_name << ", alignment " << r.alignment
+					      << (aligned ? ":\n" : ", position in cache line is not fixed:\n");
+					first = false;
+				}
+				m_out << "    " << get_kind_name(f1->sync) << " " << f1->name << " at " << f1->offset << " and "
+				      << get_kind_name(f2->sync) << " " << f2->name << " at " << f2->offset
+				      << (aligned ? " share cache line " : " may share cache line");
+				if (aligned) {
+					m_out << f2->offset / line;
+				}
+				m_out << "\n";
+				++m_count;
+			}
+		}
+	}
+
+private:
+	static const char* get_kind_name(model::sync_kind k)
+	{
+		switch (k) {
+		case model::sync_atomic:
+			return "atomic";
+		case model::sync_lock:
+			return "lock";
+		case model::sync_per_thread:
+			return "per thread field";
+		default:
+			return "field";
+		}
+	}
+
+private:
+	std::ostream& m_out;
+	unsigned m_count;
+}; // class false_sharing
+
+} // namespace reflector
+
+#endif // FALSE_SHARING_HPP
@@ -0,0 +1,831 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef GENERATOR_HPP
+#define GENERATOR_HPP
+
+#include "cache.hpp"
+#include "debug.hpp"
+#include "false_sharing.hpp"
+#include "invocation.hpp"
+#include "layout_report.hpp"
+#include "messenger.hpp"
+#include "metadata_writer.hpp"
+#include "model.hpp"
+#include "precompiled_header.hpp"
+#include "profile.hpp"
+#include "reflect_output.hpp"
+#include "selection.hpp"
+#include "statistics.hpp"
+#include "thread_pool.hpp"
+#include "utils.hpp"
+#include "visitor.hpp"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Basic/FileManager.h>
+#include <clang/Basic/LangOptions.h>
+#include <clang/Basic/SourceManager.h>
+#include <clang/Basic/TargetInfo.h>
+#include <clang/Basic/TargetOptions.h>
+#include <clang/Basic/VirtualFileSystem.h>
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Lex/Preprocessor.h>
+#include <clang/Parse/ParseAST.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace reflector {
+
+// @struct job
+// @brief One input file with its own compiler arguments and outputs.
+struct job
+{
+	typedef std::vector<std::string> arguments;
+
+	std::string input_file_name;
+	std::string output_file_name;
+	std::string metadata_file_name;
+	//@brief Writes header per type and output file including them.
+	bool split;
+	//@brief Moves strings and tables into source file beside output.
+	bool source;
+	//@brief Prints layout of reflected classes.
+	bool layout_report;
+	//@brief Looks for synchronized fields sharing cache line.
+	bool false_sharing;
+	//@brief Writes classes to output as they are extracted.
+	bool stream;
+	//@brief Threads building and rendering classes of large input,
+	//       0 means hardware threads.
+	unsigned threads;
+	//@brief Compiler arguments: include paths, macros, language standard.
+	arguments args;
+	//@brief Types and members to reflect.
+	selection::ptr select;
+}; // struct job
+
+// @struct output
+// @brief Generated file kept in memory until all of them are rendered,
+//        streamed output is already written and has no data.
+struct output
+{
+	std::string file_name;
+	std::string data;
+}; // struct output
+
+// @class writer
+// @brief Writes file only if its content differs, through temporary file
+//        and rename, so readers never see half written file and
+//        unchanged outputs keep their modification time. File '-' is
+//        standard output, it is always written.
+class writer
+{
+public:
+	explicit writer(const std::string& file_name)
+		: m_file_name(file_name)
+		, m_do(llvm::sys::fs::exists(file_name) ? "Rewrite" : "Generate")
+	{
+	}
+
+	//@param what name of content for message
+	//@return false if file already had the same content.
+	bool write(const std::string& data, const std::string& what)
+	{
+		if (utils::is_standard_stream(m_file_name)) {
+			llvm::outs() << data;
+			llvm::outs().flush();
+			if (llvm::outs().has_error()) {
+				llvm::outs().clear_error();
+				throw std::runtime_error("Can not write standard output");
+			}
+			massenger::print("Write " + what + " to standard output");
+			return true;
+		}
+		if (is_same(data)) {
+			massenger::print("Unchanged " + what + " in " + m_file_name);
+			return false;
+		}
+		int fd = -1;
+		llvm::SmallString<256> temp;
+		std::error_code error_info = llvm::sys::fs::createUniqueFile(m_file_name + "-%%%%%%%%.tmp", fd, temp);
+		if (error_info) {
+			throw std::runtime_error(error_info.message());
+		}
+		llvm::raw_fd_ostream out_file(fd, true);
+		out_file << data;
+		out_file.close();
+		if (out_file.has_error()) {
+			out_file.clear_error();
+			llvm::sys::fs::remove(temp);
+			throw std::runtime_error("Can not write file '" + m_file_name + "'");
+		}
+		error_info = llvm::sys::fs::rename(temp, m_file_name);
+		if (error_info) {
+			llvm::sys::fs::remove(temp);
+			throw std::runtime_error(error_info.message());
+		}
+		massenger::print(m_do + " " + what + " to " + m_file_name);
+		return true;
+	}
+private:
+	bool is_same(const std::string& data) const
+	{
+		llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer> > b = llvm::MemoryBuffer::getFile(m_file_name);
+		return b && (*b)->getBuffer() == data;
+	}
+
+private:
+	const std::string& m_file_name;
+	std::string m_do;
+
+}; // class writer
+
+// @class stream_output
+// @brief Renders classes into temporary file as soon as they are
+//        extracted, keeping only their names. finish writes header with
+//        forward declarations, copies rendered classes after it and adds
+//        enums, so output is the same as rendered from whole model, but
+//        memory does not grow with number of classes. Output '-' is
+//        written to standard output.
+class stream_output
+{
+public:
+	stream_output(const std::string& file_name, const std::string& guard, const profile& p)
+		: m_file_name(file_name)
+		, m_guard(guard)
+		, m_profile(p)
+		, m_size(0)
+		, m_written(false)
+	{
+		m_body_name = create_temporary(m_body);
+	}
+
+	~stream_output()
+	{
+		m_body.reset();
+		llvm::sys::fs::remove(m_body_name);
+	}
+
+	void add(const model::record& r)
+	{
+		const reflected_class c(r);
+		reflect_output(*m_body, m_profile, std::string()).dump_class(c);
+		reflect_output::add_declaration(c, m_declarations);
+		m_type_names.push_back(c.get_type_name());
+	}
+
+	//@brief Writes output through temporary file and rename, if anything
+	//       is reflected.
+	//@return false if there is nothing to write.
+	bool finish(const model::unit::enumerations& enums)
+	{
+		m_body->close();
+		check(*m_body);
+		if (m_declarations.empty() && enums.empty()) {
+			return false;
+		}
+		reflected_enum::reflected_collection es;
+		for (auto& e : enums) {
+			es.push_back(std::make_shared<reflected_enum>(e));
+		}
+		if (utils::is_standard_stream(m_file_name)) {
+			const std::size_t start = llvm::outs().tell();
+			dump(llvm::outs(), es);
+			llvm::outs().flush();
+			m_size = llvm::outs().tell() - start;
+			m_written = true;
+			check(llvm::outs());
+			massenger::print("Stream reflection to standard output");
+			return true;
+		}
+		std::unique_ptr<llvm::raw_fd_ostream> out;
+		const std::string temp = create_temporary(out);
+		try {
+			dump(*out, es);
+			m_size = out->tell();
+			out->close();
+			check(*out);
+			m_written = !is_same(temp);
+			const std::error_code error_info = m_written ? llvm::sys::fs::rename(temp, m_file_name)
+				: llvm::sys::fs::remove(temp);
+			if (error_info) {
+				throw std::runtime_error(error_info.message());
+			}
+		} catch (...) {
+			out.reset();
+			llvm::sys::fs::remove(temp);
+			throw;
+		}
+		massenger::print((m_written ? "Stream reflection to " : "Unchanged reflection in ") + m_file_name);
+		return true;
+	}
+
+	//@brief Gets size of output.
+	std::size_t get_size() const
+	{
+		return m_size;
+	}
+
+	//@brief Checks that output is written, not kept as it was.
+	bool is_written() const
+	{
+		return m_written;
+	}
+
+private:
+	void dump(llvm::raw_ostream& out, const reflected_enum::reflected_collection& es) const
+	{
+		reflect_output r(out, m_profile, m_guard);
+		r.dump_begin(m_declarations);
+		copy_body(out);
+		r.dump_end(es, m_type_names);
+	}
+
+	//@brief Creates temporary file beside output, or in temporary
+	//       directory for standard output.
+	std::string create_temporary(std::unique_ptr<llvm::raw_fd_ostream>& out) const
+	{
+		int fd = -1;
+		llvm::SmallString<256> temp;
+		const std::error_code error_info = utils::is_standard_stream(m_file_name)
+			? llvm::sys::fs::createTemporaryFile("greflect", "tmp", fd, temp)
+			: llvm::sys::fs::createUniqueFile(m_file_name + "-%%%%%%%%.tmp", fd, temp);
+		if (error_info) {
+			throw std::runtime_error(error_info.message());
+		}
+		out.reset(new llvm::raw_fd_ostream(fd, true));
+		return temp.str();
+	}
+
+	void copy_body(llvm::raw_ostream& out) const
+	{
+		std::ifstream in(m_body_name.c_str(), std::ios::binary);
+		char buffer[65536];
+		while (in.read(buffer, sizeof(buffer)) || 0 != in.gcount()) {
+			out.write(buffer, in.gcount());
+		}
+		if (in.bad()) {
+			throw std::runtime_error("Can not read file '" + m_body_name + "'");
+		}
+	}
+
+	//@brief Compares rendered file with output chunk by chunk, so output
+	//       with the same content keeps its modification time.
+	bool is_same(const std::string& temp) const
+	{
+		std::uint64_t size = 0;
+		std::uint64_t temp_size = 0;
+		if (llvm::sys::fs::file_size(m_file_name, size) || llvm::sys::fs::file_size(temp, temp_size) ||
+		    size != temp_size) {
+			return false;
+		}
+		std::ifstream in(m_file_name.c_str(), std::ios::binary);
+		std::ifstream temp_in(temp.c_str(), std::ios::binary);
+		char buffer[65536];
+		char temp_buffer[sizeof(buffer)];
+		while (in && temp_in) {
+			in.read(buffer, sizeof(buffer));
+			temp_in.read(temp_buffer, sizeof(temp_buffer));
+			if (in.gcount() != temp_in.gcount() || 0 != std::memcmp(buffer, temp_buffer, in.gcount())) {
+				return false;
+			}
+		}
+		return !in.bad() && !temp_in.bad() && in.eof() && temp_in.eof();
+	}
+
+	void check(llvm::raw_fd_ostream& out) const
+	{
+		if (out.has_error()) {
+			out.clear_error();
+			throw std::runtime_error("Can not write file '" + m_file_name + "'");
+		}
+	}
+
+private:
+	const std::string& m_file_name;
+	std::string m_guard;
+	const profile& m_profile;
+	std::unique_ptr<llvm::raw_fd_ostream> m_body;
+	std::string m_body_name;
+	reflect_output::declarations m_declarations;
+	reflect_output::type_names m_type_names;
+	std::size_t m_size;
+	bool m_written;
+}; // class stream_output
+
+// @class generator
+// @brief Parses one input file with own compiler instance into model of
+//        its reflected types, then renders and writes outputs from model.
+//        Generators of different jobs can run in parallel.
+class generator
+{
+public:
+	typedef llvm::IntrusiveRefCntPtr<clang::vfs::FileSystem> file_system;
+	typedef std::vector<output> output_files;
+public:
+	generator(const job& j, const profile& p, const file_system& fs, const cache::ptr& c,
+		  const precompiled_header::ptr& pch);
+
+	//@brief Parses input file, or takes its model from cache, and
+	//       writes outputs rendered from it.
+	void run();
+
+	//@brief Gets files which outputs depend on, input file first.
+	const cache::entry::dependencies& get_dependencies() const
+	{
+		return m_dependencies;
+	}
+
+	//@brief Gets generated files.
+	const output_files& get_outputs() const
+	{
+		return m_outputs;
+	}
+
+	//@brief Gets model of reflected types.
+	const model::unit& get_unit() const
+	{
+		return m_unit;
+	}
+
+	//@brief Gets number of synchronized field pairs sharing cache line.
+	unsigned get_false_sharing() const
+	{
+		return m_false_sharing;
+	}
+
+	//@brief Gets times of phases and counts of run.
+	const statistics& get_statistics() const
+	{
+		return m_stats;
+	}
+private:
+	std::string get_cache_key() const;
+
+	void initialize_compiler();
+
+	void set_invocation();
+
+	void load_precompiled_header();
+
+	void set_default_target_triple();
+
+	void set_main_file_id();
+
+	void run_streaming();
+
+	void parse_ast(const visitor::record_handler&);
+
+	void report_skipped(const selection::skipped&) const;
+
+	void report_layout() const;
+
+	void check_false_sharing();
+
+	void render(const model::unit&);
+
+	void render(const reflected_class::reflected_collection&, const reflected_enum::reflected_collection&);
+
+	output render(const std::string&,
+		      const reflected_class::reflected_collection&,
+		      const reflected_enum::reflected_collection&) const;
+
+	unsigned get_threads(std::size_t) const;
+
+	std::string get_include_guard(const std::string&) const;
+
+	void render_source(const reflected_class::reflected_collection&);
+
+	void add_extra_dependencies();
+
+	void add_dependency(const std::string&);
+
+	void collect_dependencies();
+
+	void write();
+private:
+	clang::CompilerInstance m_compiler;
+	const job& m_job;
+	const profile& m_profile;
+	cache::ptr m_cache;
+	cache::entry m_entry;
+	model::unit m_unit;
+	cache::entry::dependencies m_dependencies;
+	output_files m_outputs;
+	precompiled_header::ptr m_pch;
+	precompiled_header::built m_pch_built;
+	statistics m_stats;
+	unsigned m_false_sharing;
+}; // class generator
+
+generator::generator(const job& j, const profile& p, const file_system& fs, const cache::ptr& c,
+		     const precompiled_header::ptr& pch)
+	: m_job(j)
+	, m_profile(p)
+	, m_cache(c)
+	, m_pch(pch)
+	, m_false_sharing(0)
+{
+	m_compiler.setVirtualFileSystem(fs);
+}
+
+void generator::run()
+{
+	if (m_job.stream) {
+		run_streaming();
+		return;
+	}
+	const std::string key = 0 == m_cache ? std::string() : get_cache_key();
+	if (0 != m_cache && m_cache->find(key, m_entry) && model::parse(m_entry.model, m_unit)) {
+		massenger::print("Reuse cached model of " + m_job.input_file_name);
+		m_stats.set_input(m_job.input_file_name, true);
+	} else {
+		const std::time_t start = std::time(0);
+		m_stats.set_input(m_job.input_file_name, false);
+		m_entry = cache::entry();
+		m_unit = model::unit();
+		{
+			statistics::timer t(m_stats, statistics::phase_setup);
+			initialize_compiler();
+		}
+		{
+			statistics::timer t(m_stats, statistics::phase_parse);
+			parse_ast(visitor::record_handler());
+			collect_dependencies();
+			model::serialize(m_unit, m_entry.model);
+		}
+		// @note: Model of input with errors may be partial, and missing
+		//        include is not among its dependencies to invalidate it.
+		if (0 != m_cache && !m_compiler.getDiagnostics().hasErrorOccurred()) {
+			m_cache->store(key, m_entry, start);
+		}
+	}
+	add_extra_dependencies();
+	m_stats.add(m_unit);
+	statistics::timer t(m_stats, statistics::phase_emission);
+	render(m_unit);
+	write();
+	if (m_job.layout_report) {
+		report_layout();
+	}
+	if (m_job.false_sharing) {
+		check_false_sharing();
+	}
+}
+
+// @note: Model does not depend on outputs, so outputs of other flavour
+//        are rendered from cached model.
+std::string generator::get_cache_key() const
+{
+	cache::strings parts;
+	parts.push_back(m_job.input_file_name);
+	parts.push_back(0 == m_pch ? "" : m_pch->get_header());
+	parts.push_back(m_job.select->get_key());
+	parts.insert(parts.end(), m_job.args.begin(), m_job.args.end());
+	return m_cache->get_key(parts);
+}
+
+void generator::initialize_compiler()
+{
+	m_compiler.createDiagnostics();
+	set_invocation();
+	set_default_target_triple();
+	if (0 != m_pch) {
+		m_pch_built = m_pch->get(m_job.args);
+		m_compiler.getPreprocessorOpts().ImplicitPCHInclude = m_pch_built.file_name;
+	}
+	m_compiler.createFileManager();
+	m_compiler.createSourceManager(m_compiler.getFileManager());
+	m_compiler.createPreprocessor(clang::TU_Complete);
+	m_compiler.getPreprocessorOpts().UsePredefines = false;
+	m_compiler.createASTContext();
+	set_main_file_id();
+	load_precompiled_header();
+}
+
+void generator::load_precompiled_header()
+{
+	const std::string& pch = m_compiler.getPreprocessorOpts().ImplicitPCHInclude;
+	if (pch.empty()) {
+		return;
+	}
+	m_compiler.createPCHExternalASTSource(pch, !m_pch_built.validate, false, 0, false);
+	if (0 == m_compiler.getASTContext().getExternalSource()) {
+		throw std::runtime_error("Can not load precompiled header '" + pch + "'");
+	}
+}
+
+void generator::set_invocation()
+{
+	ASSERT(m_compiler.hasDiagnostics());
+	m_compiler.setInvocation(invocation::create(m_job.args, m_job.input_file_name, m_compiler.getDiagnostics()));
+}
+
+void generator::set_default_target_triple()
+{
+	std::shared_ptr<clang::TargetOptions> to = std::make_shared<clang::TargetOptions>();
+	to->Triple = llvm::sys::getDefaultTargetTriple();
+	ASSERT(m_compiler.hasDiagnostics());
+	m_compiler.setTarget(clang::TargetInfo::CreateTargetInfo(m_compiler.getDiagnostics(), to));
+}
+
+void generator::set_main_file_id()
+{
+	ASSERT(m_compiler.hasSourceManager());
+	const clang::FileEntry* file = m_compiler.getFileManager().getFile(m_job.input_file_name);
+	if (0 == file) {
+		throw std::runtime_error("Can not open input file '" + m_job.input_file_name + "'");
+	}
+	clang::SourceManager& sc_mgr = m_compiler.getSourceManager();
+	sc_mgr.setMainFileID(sc_mgr.createFileID(file, clang::SourceLocation(), clang::SrcMgr::C_User));
+}
+
+// @note: Model of classes is not kept, so it is not cached and nothing
+//        but the header output is written.
+void generator::run_streaming()
+{
+	m_stats.set_input(m_job.input_file_name, false);
+	{
+		statistics::timer t(m_stats, statistics::phase_setup);
+		initialize_compiler();
+	}
+	stream_output out(m_job.output_file_name, get_include_guard(m_job.output_file_name), m_profile);
+	{
+		statistics::timer t(m_stats, statistics::phase_parse);
+		parse_ast(
+			[this, &out](const model::record& r)
+			{
+				statistics::timer t(m_stats, statistics::phase_emission);
+				m_stats.add(r);
+				out.add(r);
+			}
+		);
+		collect_dependencies();
+	}
+	add_extra_dependencies();
+	m_stats.add(m_unit);
+	statistics::timer t(m_stats, statistics::phase_emission);
+	if (out.finish(m_unit.enums)) {
+		output o;
+		o.file_name = m_job.output_file_name;
+		m_outputs.push_back(o);
+		m_stats.add_output(out.get_size(), out.is_written());
+	}
+}
+
+void generator::parse_ast(const visitor::record_handler& h)
+{
+	ASSERT(m_compiler.hasSourceManager());
+	clang::SourceManager& sc_mgr = m_compiler.getSourceManager();
+	ASSERT(m_compiler.hasPreprocessor());
+	clang::Preprocessor& preproc = m_compiler.getPreprocessor();
+	preproc.getDiagnostics().setSuppressAllDiagnostics(true);
+	m_compiler.getDiagnosticClient().BeginSourceFile(m_compiler.getLangOpts(), &preproc);
+	ASSERT(m_compiler.hasASTContext());
+	ASSERT(0 != m_job.select);
+	reflector::visitor visitor(sc_mgr, *m_job.select, m_stats);
+	visitor.set_record_handler(h);
+	reflector::consumer consumer(visitor, m_stats);
+	// @note: Bodies of functions are skipped, only declarations are reflected.
+	ParseAST(preproc, &consumer, m_compiler.getASTContext(), false, clang::TU_Complete, 0, true);
+	m_compiler.getDiagnosticClient().EndSourceFile();
+	m_unit = visitor.get_unit();
+	m_stats.add(visitor.get_skipped());
+	report_skipped(visitor.get_skipped());
+}
+
+void generator::report_skipped(const selection::skipped& k) const
+{
+	if (0 == k.classes + k.enums + k.methods + k.fields) {
+		return;
+	}
+	massenger::print("Selection left out " + std::to_string(k.classes) + " classes, " +
+			 std::to_string(k.enums) + " enums, " + std::to_string(k.methods) + " methods and " +
+			 std::to_string(k.fields) + " fields of " + m_job.input_file_name);
+}
+
+void generator::report_layout() const
+{
+	std::ostringstream out;
+	layout_report r(out);
+	for (auto& c : m_unit.classes) {
+		r.dump(c);
+	}
+	r.dump_total();
+	massenger::print("Layout of classes of " + m_job.input_file_name + ":\n" + out.str());
+}
+
+void generator::check_false_sharing()
+{
+	std::ostringstream out;
+	false_sharing f(out);
+	for (auto& c : m_unit.classes) {
+		f.check(c);
+	}
+	m_false_sharing = f.get_count();
+	if (0 != m_false_sharing) {
+		massenger::worrning("False sharing in " + m_job.input_file_name + ":\n" + out.str());
+	}
+}
+
+void generator::render(const model::unit& u)
+{
+	std::vector<reflected_class::ptr> built(u.classes.size());
+	thread_pool(get_threads(built.size())).for_each_rethrow(built.size(),
+		[&u, &built](unsigned, std::size_t i)
+		{
+			built[i] = std::make_shared<reflected_class>(u.classes[i]);
+		}
+	);
+	if (!m_job.split) {
+		reflected_class::share_templates(built);
+	}
+	const reflected_class::reflected_collection classes(built.begin(), built.end());
+	reflected_enum::reflected_collection enums;
+	for (auto& e : u.enums) {
+		enums.push_back(std::make_shared<reflected_enum>(e));
+	}
+	if (!classes.empty() || !enums.empty()) {
+		render(classes, enums);
+	}
+	if (!m_job.metadata_file_name.empty()) {
+		metadata_writer metadata;
+		output o;
+		o.file_name = m_job.metadata_file_name;
+		metadata.add(u.classes);
+		metadata.serialize(o.data);
+		m_outputs.push_back(o);
+	}
+}
+
+void generator::render(const reflected_class::reflected_collection& classes,
+		       const reflected_enum::reflected_collection& enums)
+{
+	if (m_job.source) {
+		render_source(classes);
+	}
+	if (!m_job.split) {
+		m_outputs.push_back(render(m_job.output_file_name, classes, enums));
+		return;
+	}
+	const std::vector<reflected_class::ptr> cs(classes.begin(), classes.end());
+	std::vector<std::string> names;
+	for (auto& c : cs) {
+		names.push_back(c->get_qualified_name());
+	}
+	for (auto e : enums) {
+		names.push_back(e->get_qualified_name());
+	}
+	std::vector<std::string> file_names;
+	utils::generate_part_file_names(m_job.output_file_name, names, file_names);
+	output_files class_outputs(cs.size());
+	thread_pool(get_threads(cs.size())).for_each_rethrow(cs.size(),
+		[this, &cs, &file_names, &class_outputs](unsigned, std::size_t i)
+		{
+			class_outputs[i] = render(file_names[i], reflected_class::reflected_collection(1, cs[i]),
+						  reflected_enum::reflected_collection());
+		}
+	);
+	std::vector<std::string> parts;
+	for (auto& o : class_outputs) {
+		parts.push_back(llvm::sys::path::filename(o.file_name));
+		m_outputs.push_back(o);
+	}
+	std::size_t i = cs.size();
+	for (auto e : enums) {
+		const std::string& n = file_names[i++];
+		m_outputs.push_back(render(n, reflected_class::reflected_collection(), reflected_enum::reflected_collection(1, e)));
+		parts.push_back(llvm::sys::path::filename(n));
+	}
+	output o;
+	o.file_name = m_job.output_file_name;
+	llvm::raw_string_ostream out(o.data);
+	reflect_output(out, m_profile, get_include_guard(o.file_name)).dump_umbrella(parts);
+	out.flush();
+	m_outputs.push_back(o);
+}
+
+output generator::render(const std::string& file_name,
+			 const reflected_class::reflected_collection& classes,
+			 const reflected_enum::reflected_collection& enums) const
+{
+	output o;
+	o.file_name = file_name;
+	llvm::raw_string_ostream out(o.data);
+	reflect_output r(out, m_profile, get_include_guard(file_name));
+	r.set_threads(get_threads(classes.size()));
+	r.dump(classes, enums, m_job.source ? member_output::declaration_part : member_output::inline_part);
+	out.flush();
+	return o;
+}
+
+// @note: Small inputs do not pay for starting threads.
+unsigned generator::get_threads(std::size_t classes) const
+{
+	return classes < reflect_output::min_parallel_classes() ? 1 : m_job.threads;
+}
+
+// @note: Output written to standard output is guarded as the default
+//        output of input would be.
+std::string generator::get_include_guard(const std::string& file_name) const
+{
+	return utils::generate_include_guard(utils::is_standard_stream(file_name) ?
+					     utils::generate_out_file_name(m_job.input_file_name) : file_name);
+}
+
+void generator::render_source(const reflected_class::reflected_collection& classes)
+{
+	llvm::SmallString<256> input(m_job.input_file_name);
+	llvm::SmallString<256> output(m_job.output_file_name);
+	llvm::sys::fs::make_absolute(input);
+	llvm::sys::fs::make_absolute(output);
+	std::vector<std::string> includes;
+	if (llvm::sys::path::parent_path(input) == llvm::sys::path::parent_path(output)) {
+		includes.push_back(llvm::sys::path::filename(input));
+	} else {
+		includes.push_back(input.str());
+	}
+	includes.push_back(llvm::sys::path::filename(output));
+	output o;
+	o.file_name = utils::generate_source_file_name(m_job.output_file_name);
+	llvm::raw_string_ostream out(o.data);
+	reflect_output r(out, m_profile, std::string());
+	r.set_threads(get_threads(classes.size()));
+	r.dump_source(includes, classes);
+	out.flush();
+	m_outputs.push_back(o);
+}
+
+//@brief Takes files of model and adds files outputs depend on besides it.
+void generator::add_extra_dependencies()
+{
+	m_dependencies = m_entry.files;
+	const std::string extra[] = { m_profile.get_file_name(), m_job.select->get_exclude_file_name() };
+	for (auto& n : extra) {
+		if (!n.empty()) {
+			cache::dependency d = {};
+			d.file_name = n;
+			m_dependencies.push_back(d);
+		}
+	}
+}
+
+void generator::add_dependency(const std::string& file_name)
+{
+	cache::dependency d = {};
+	d.file_name = file_name;
+	m_entry.files.push_back(d);
+}
+
+void generator::collect_dependencies()
+{
+	ASSERT(m_compiler.hasSourceManager());
+	clang::SourceManager& sc_mgr = m_compiler.getSourceManager();
+	std::vector<std::string> names;
+	utils::get_file_names(sc_mgr, names);
+	for (auto& d : m_pch_built.dependencies) {
+		names.push_back(d.file_name);
+	}
+	std::sort(names.begin(), names.end());
+	names.erase(std::unique(names.begin(), names.end()), names.end());
+	m_entry.files.clear();
+	add_dependency(m_job.input_file_name);
+	for (auto& n : names) {
+		if (n != m_job.input_file_name) {
+			add_dependency(n);
+		}
+	}
+}
+
+void generator::write()
+{
+	for (auto& o : m_outputs) {
+		const bool metadata = o.file_name == m_job.metadata_file_name;
+		m_stats.add_output(o.data.size(), writer(o.file_name).write(o.data, metadata ? "metadata" : "reflection"));
+	}
+}
+
+} // namespace reflector
+
+#endif // GENERATOR_HPP
@@ -0,0 +1,53 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef INVOCATION_HPP
+#define INVOCATION_HPP
+
+#include "debug.hpp"
+
+#include <clang/Basic/Diagnostic.h>
+#include <clang/Frontend/CompilerInvocation.h>
+#include <clang/Lex/HeaderSearchOptions.h>
+
+#include <string>
+#include <vector>
+
+// @note: Compiler invocation shared by parsing of inputs and building of
+//        precompiled header, which is usable only with the same options.
+namespace invocation {
+
+typedef std::vector<std::string> arguments;
+
+void add_default_header_search_paths(clang::HeaderSearchOptions& h)
+{
+	h.AddPath("/usr/local/include", clang::frontend::Angled, false, false);
+	h.AddPath("/usr/include", clang::frontend::Angled, false, false);
+}
+
+clang::CompilerInvocation* create(const arguments& args, const std::string& input, clang::DiagnosticsEngine& d)
+{
+	ASSERT(!input.empty());
+	clang::CompilerInvocation* invocation = new clang::CompilerInvocation;
+	std::vector<const char*> argv;
+	for (auto& a : args) {
+		argv.push_back(a.c_str());
+	}
+	argv.push_back(input.c_str());
+	// @note: Language standard is taken from -std= of arguments, or is
+	//        default of compiler for input kind.
+	clang::CompilerInvocation::CreateFromArgs(*invocation, argv.data(), argv.data() + argv.size(), d);
+	add_default_header_search_paths(invocation->getHeaderSearchOpts());
+	return invocation;
+}
+
+} // namespace invocation
+
+#endif // INVOCATION_HPP
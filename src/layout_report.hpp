@@ -0,0 +1,256 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef LAYOUT_REPORT_HPP
+#define LAYOUT_REPORT_HPP
+
+#include "model.hpp"
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace reflector {
+
+// @class layout_report
+// @brief Describes memory layout of reflected classes: offsets of fields,
+//        padding holes and cache line boundaries. Proposes field order
+//        which removes padding, and order which moves fields annotated
+//        "hot" into the first cache line.
+class layout_report
+{
+private:
+	// @struct item
+	// @brief Field or subobject occupying [offset, offset + size).
+	struct item
+	{
+		unsigned offset;
+		unsigned size;
+		std::string description;
+	}; // struct item
+
+	typedef std::vector<item> items;
+	typedef std::vector<const model::field*> fields;
+public:
+	static unsigned cache_line_size()
+	{
+		return 64;
+	}
+
+	explicit layout_report(std::ostream& out)
+		: m_out(out)
+		, m_classes(0)
+		, m_size(0)
+		, m_padding(0)
+	{
+	}
+
+	void dump(const model::record& r)
+	{
+		items is;
+		for (auto& o : r.subobjects) {
+			item i = { o.offset, o.size, o.name };
+			is.push_back(i);
+		}
+		for (auto& f : r.fields) {
+			item i = { f.offset, f.size, f.type + " " + f.name + (f.is_bit_field ? " (bit field)" : "") +
+						     (f.is_hot ? " (hot)" : "") };
+			is.push_back(i);
+		}
+		std::stable_sort(is.begin(), is.end(),
+			[](const item& i1, const item& i2)
+			{
+				return i1.offset < i2.offset;
+			}
+		);
+		std::ostringstream body;
+		unsigned end = 0;
+		unsigned padding = 0;
+		unsigned line = 0;
+		for (auto& i : is) {
+			if (end < i.offset) {
+				dump_item(body, end, i.offset - end, "(padding)");
+				padding += i.offset - end;
+			}
+			for (; (line + 1) * cache_line_size() <= i.offset; ++line) {
+				body << "    ---- cache line " << line + 1 << " at " << (line + 1) * cache_line_size() << " ----\n";
+			}
+			const bool crosses = 0 != i.size &&
+					     i.offset / cache_line_size() != (i.offset + i.size - 1) / cache_line_size();
+			dump_item(body, i.offset, i.size, i.description + (crosses ? " (crosses cache line)" : ""));
+			end = std::max(end, i.offset + i.size);
+		}
+		if (end < r.size) {
+			dump_item(body, end, r.size - end, "(tail padding)");
+			padding += r.size - end;
+		}
+		m_out << r.kind << " " << r.qualified_name << ": size " << r.size << ", alignment " << r.alignment
+		      << ", " << padding << " bytes of padding\n";
+		m_out << "    offset  size  member\n" << body.str();
+		dump_suggestions(r);
+		++m_classes;
+		m_size += r.size;
+		m_padding += padding;
+	}
+
+	//@brief Writes padding of all dumped classes.
+	void dump_total()
+	{
+		m_out << "Padding of " << m_classes << " classes: " << m_padding << " of " << m_size << " bytes";
+		if (0 != m_size) {
+			m_out << " (" << m_padding * 100 / m_size << "%)";
+		}
+		m_out << "\n";
+	}
+
+private:
+	static void dump_item(std::ostream& out, unsigned offset, unsigned size, const std::string& description)
+	{
+		out << "    " << std::setw(6) << offset << "  " << std::setw(4) << size << "  " << description << "\n";
+	}
+
+	//@brief Proposes orders only for plain fields, bit fields, unions
+	//       and virtual bases are laid out by rules not repeated here.
+	void dump_suggestions(const model::record& r)
+	{
+		if (r.fields.empty() || r.has(model::trait_union) || 0 != r.num_virtual_bases) {
+			return;
+		}
+		fields current;
+		for (auto& f : r.fields) {
+			if (f.is_bit_field) {
+				return;
+			}
+			current.push_back(&f);
+		}
+		fields compact(current);
+		std::stable_sort(compact.begin(), compact.end(),
+			[](const model::field* f1, const model::field* f2)
+			{
+				return f1->alignment > f2->alignment;
+			}
+		);
+		unsigned end = 0;
+		const unsigned size = place(r, compact, end);
+		if (size < r.size) {
+			m_out << "    smaller order, size " << size << ", " << r.size - size << " bytes less:";
+			dump_order(compact);
+		}
+		fields hot(compact);
+		std::stable_partition(hot.begin(), hot.end(),
+			[](const model::field* f)
+			{
+				return f->is_hot;
+			}
+		);
+		if (!hot.front()->is_hot || is_hot_first(current)) {
+			return;
+		}
+		fields filled(hot);
+		const fields::iterator cold = std::find_if(filled.begin(), filled.end(),
+			[](const model::field* f)
+			{
+				return !f->is_hot;
+			}
+		);
+		const std::size_t hot_count = cold - filled.begin();
+		unsigned hot_end = 0;
+		place(r, fields(), hot_end);
+		fill(filled.begin(), cold, hot_end);
+		place(r, fields(filled.begin(), cold), hot_end);
+		fill(cold, filled.end(), hot_end);
+		// @note: Filling is greedy, order by alignment is kept when it is
+		//        not larger.
+		if (place(r, filled, end) <= place(r, hot, end)) {
+			hot.swap(filled);
+		}
+		place(r, fields(hot.begin(), hot.begin() + hot_count), hot_end);
+		m_out << "    hot fields first, size " << place(r, hot, end) << ", hot fields end at " << hot_end
+		      << (hot_end <= cache_line_size() ? ", in the first cache line:" : ", beyond the first cache line:");
+		dump_order(hot);
+	}
+
+	//@brief Orders fields placed from offset on, each next one is the
+	//       first which needs the least padding, so fields ordered by
+	//       alignment fill padding left after smaller ones, e.g. hot ones.
+	static void fill(fields::iterator first, fields::iterator last, unsigned offset)
+	{
+		for (fields::iterator i = first; i != last; ++i) {
+			fields::iterator best = i;
+			for (fields::iterator j = i; j != last; ++j) {
+				if (align(offset, (*j)->alignment) < align(offset, (*best)->alignment)) {
+					best = j;
+				}
+			}
+			std::rotate(i, best, best + 1);
+			offset = align(offset, (*i)->alignment) + (*i)->size;
+		}
+	}
+
+	//@brief Checks that no hot field follows cold one.
+	static bool is_hot_first(const fields& fs)
+	{
+		bool cold = false;
+		for (auto f : fs) {
+			if (f->is_hot && cold) {
+				return false;
+			}
+			cold = cold || !f->is_hot;
+		}
+		return true;
+	}
+
+	//@brief Places fields after subobjects in given order, as compiler does.
+	//@param end gets end of the last field
+	//@return Size of record.
+	static unsigned place(const model::record& r, const fields& order, unsigned& end)
+	{
+		unsigned first = r.size;
+		for (auto& f : r.fields) {
+			first = std::min(first, f.offset);
+		}
+		end = 0;
+		for (auto& o : r.subobjects) {
+			if (o.offset < first) {
+				end = std::max(end, o.offset + o.size);
+			}
+		}
+		for (auto f : order) {
+			end = align(end, f->alignment) + f->size;
+		}
+		return std::max(1u, align(end, r.alignment));
+	}
+
+	static unsigned align(unsigned offset, unsigned alignment)
+	{
+		return 0 == alignment ? offset : (offset + alignment - 1) / alignment * alignment;
+	}
+
+	void dump_order(const fields& order)
+	{
+		for (auto f : order) {
+			m_out << " " << f->name;
+		}
+		m_out << "\n";
+	}
+
+private:
+	std::ostream& m_out;
+	unsigned m_classes;
+	unsigned long long m_size;
+	unsigned long long m_padding;
+}; // class layout_report
+
+} // namespace reflector
+
+#endif // LAYOUT_REPORT_HPP
@@ -0,0 +1,83 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef MEMBER_OUTPUT_HPP
+#define MEMBER_OUTPUT_HPP
+
+#include <clang/Basic/LLVM.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <string>
+
+//@class member_output
+//@brief Dumps static member function of reflect specialization either
+//       defined in class, or declared in class of header and defined
+//       out of class in source file.
+class member_output
+{
+public:
+	enum part {
+		inline_part,
+		declaration_part,
+		definition_part
+	};
+
+public:
+	member_output(clang::raw_ostream& out, part p, const std::string& class_name)
+		: m_out(out)
+		, m_part(p)
+		, m_class_name(class_name)
+	{
+	}
+
+	part get_part() const
+	{
+		return m_part;
+	}
+
+	//@param return_type is looked up in class scope, as trailing return type
+	//@param signature name and parameters of member
+	//@param body statements indented by two tabs
+	void dump(const std::string& return_type, const std::string& signature, const std::string& body) const
+	{
+		switch (m_part) {
+		case inline_part:
+			m_out << "\tstatic " << return_type << " " << signature << "\n\t{\n" << body << "\t}\n\n";
+			break;
+		case declaration_part:
+			m_out << "\tstatic " << return_type << " " << signature << ";\n\n";
+			break;
+		case definition_part:
+			m_out << "auto reflect<" << m_class_name << ">::" << signature << " -> " << return_type << "\n{\n";
+			dump_unindented(body);
+			m_out << "}\n\n";
+			break;
+		}
+	}
+
+private:
+	void dump_unindented(const std::string& body) const
+	{
+		std::string::size_type b = 0;
+		while (b < body.size()) {
+			std::string::size_type e = body.find('\n', b);
+			e = std::string::npos == e ? body.size() : e + 1;
+			m_out << body.substr('\t' == body[b] ? b + 1 : b, '\t' == body[b] ? e - b - 1 : e - b);
+			b = e;
+		}
+	}
+
+private:
+	clang::raw_ostream& m_out;
+	part m_part;
+	std::string m_class_name;
+}; // class member_output
+
+#endif // MEMBER_OUTPUT_HPP
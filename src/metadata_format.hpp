@@ -0,0 +1,125 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef METADATA_FORMAT_HPP
+#define METADATA_FORMAT_HPP
+
+#include <cstdint>
+
+// @note: Layout of binary metadata file written by 'greflect -m'.
+//        The file starts with header, followed by tables of records and
+//        the string table. Tables are arrays of records of native byte
+//        order, referenced by offset from the start of file. Strings are
+//        referenced by offset into the string table, offset 0 is "".
+//        Classes are sorted by qualified name.
+namespace reflector {
+namespace metadata {
+
+static const char magic[4] = { 'G', 'R', 'F', 'M' };
+static const std::uint32_t version = 1;
+
+enum trait {
+	trait_abstract = 1 << 0,
+	trait_polymorphic = 1 << 1,
+	trait_aggregate = 1 << 2,
+	trait_union = 1 << 3,
+	trait_empty = 1 << 4,
+	trait_trivial = 1 << 5,
+	trait_trivially_copyable = 1 << 6,
+	trait_standard_layout = 1 << 7,
+	trait_pod = 1 << 8,
+	trait_default_constructor = 1 << 9
+};
+
+enum flag {
+	flag_const = 1 << 0,
+	flag_virtual = 1 << 1,
+	flag_bit_field = 1 << 2
+};
+
+// @note: Values are the same as clang::AccessSpecifier ones.
+enum access {
+	access_public = 0,
+	access_protected = 1,
+	access_private = 2,
+	access_none = 3
+};
+
+struct table
+{
+	std::uint32_t offset;
+	std::uint32_t count;
+};
+
+struct header
+{
+	char magic[4];
+	std::uint32_t version;
+	std::uint32_t size;
+	table classes;
+	table bases;
+	table methods;
+	table params;
+	table fields;
+	table strings;
+};
+
+struct class_record
+{
+	std::uint32_t name;
+	std::uint32_t qualified_name;
+	std::uint32_t kind;
+	std::uint32_t traits;
+	std::uint32_t size;
+	std::uint32_t alignment;
+	std::uint32_t first_base;
+	std::uint32_t base_count;
+	std::uint32_t first_method;
+	std::uint32_t method_count;
+	std::uint32_t first_field;
+	std::uint32_t field_count;
+};
+
+struct base_record
+{
+	std::uint32_t name;
+	std::uint32_t access;
+	std::uint32_t flags;
+};
+
+struct method_record
+{
+	std::uint32_t name;
+	std::uint32_t return_type;
+	std::uint32_t flags;
+	std::uint32_t first_param;
+	std::uint32_t param_count;
+};
+
+struct param_record
+{
+	std::uint32_t type;
+};
+
+struct field_record
+{
+	std::uint32_t name;
+	std::uint32_t type;
+	std::uint32_t access;
+	std::uint32_t flags;
+	std::uint32_t offset;
+	std::uint32_t size;
+	std::uint32_t alignment;
+};
+
+} // namespace metadata
+} // namespace reflector
+
+#endif // METADATA_FORMAT_HPP
@@ -0,0 +1,246 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef METADATA_READER_HPP
+#define METADATA_READER_HPP
+
+#include "metadata_format.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace reflector {
+namespace metadata {
+
+// @class range
+template <typename T>
+class range
+{
+public:
+	range(const T* b, const T* e)
+		: m_begin(b)
+		, m_end(e)
+	{
+	}
+
+	const T* begin() const
+	{
+		return m_begin;
+	}
+
+	const T* end() const
+	{
+		return m_end;
+	}
+
+	std::size_t size() const
+	{
+		return m_end - m_begin;
+	}
+
+	bool empty() const
+	{
+		return m_begin == m_end;
+	}
+
+private:
+	const T* m_begin;
+	const T* m_end;
+}; // class range
+
+// @class reader
+// @brief Maps metadata file written by 'greflect -m' into memory and
+//        answers queries in place, it neither parses nor allocates.
+//        Dependency free, tools include only this file and
+//        metadata_format.hpp.
+class reader
+{
+public:
+	reader()
+		: m_data(0)
+		, m_size(0)
+	{
+	}
+
+	~reader()
+	{
+		close();
+	}
+
+	//@brief Maps and validates file.
+	//@return false if file can not be mapped or is not valid metadata.
+	bool open(const char* file_name)
+	{
+		close();
+		const int fd = ::open(file_name, O_RDONLY);
+		if (-1 == fd) {
+			return false;
+		}
+		struct stat st;
+		if (0 != ::fstat(fd, &st) || static_cast<std::size_t>(st.st_size) < sizeof(header)) {
+			::close(fd);
+			return false;
+		}
+		void* data = ::mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (MAP_FAILED == data) {
+			return false;
+		}
+		m_data = static_cast<const char*>(data);
+		m_size = st.st_size;
+		if (!validate()) {
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	void close()
+	{
+		if (0 != m_data) {
+			::munmap(const_cast<char*>(m_data), m_size);
+		}
+		m_data = 0;
+		m_size = 0;
+	}
+
+	bool is_open() const
+	{
+		return 0 != m_data;
+	}
+
+	const header& get_header() const
+	{
+		return *reinterpret_cast<const header*>(m_data);
+	}
+
+	const char* get_string(std::uint32_t offset) const
+	{
+		const table& t = get_header().strings;
+		return offset < t.count ? m_data + t.offset + offset : "";
+	}
+
+	range<class_record> get_classes() const
+	{
+		return get_range<class_record>(get_header().classes, 0, get_header().classes.count);
+	}
+
+	range<base_record> get_bases(const class_record& c) const
+	{
+		return get_range<base_record>(get_header().bases, c.first_base, c.base_count);
+	}
+
+	range<method_record> get_methods(const class_record& c) const
+	{
+		return get_range<method_record>(get_header().methods, c.first_method, c.method_count);
+	}
+
+	range<param_record> get_params(const method_record& m) const
+	{
+		return get_range<param_record>(get_header().params, m.first_param, m.param_count);
+	}
+
+	range<field_record> get_fields(const class_record& c) const
+	{
+		return get_range<field_record>(get_header().fields, c.first_field, c.field_count);
+	}
+
+	//@brief Binary search of class by qualified name.
+	//@return null if there is no such class.
+	const class_record* find_class(const char* qualified_name) const
+	{
+		range<class_record> classes = get_classes();
+		const class_record* b = classes.begin();
+		const class_record* e = classes.end();
+		while (b != e) {
+			const class_record* m = b + (e - b) / 2;
+			const int r = std::strcmp(get_string(m->qualified_name), qualified_name);
+			if (0 == r) {
+				return m;
+			}
+			if (r < 0) {
+				b = m + 1;
+			} else {
+				e = m;
+			}
+		}
+		return 0;
+	}
+
+	const method_record* find_method(const class_record& c, const char* name) const
+	{
+		for (const method_record& m : get_methods(c)) {
+			if (0 == std::strcmp(get_string(m.name), name)) {
+				return &m;
+			}
+		}
+		return 0;
+	}
+
+	const field_record* find_field(const class_record& c, const char* name) const
+	{
+		for (const field_record& f : get_fields(c)) {
+			if (0 == std::strcmp(get_string(f.name), name)) {
+				return &f;
+			}
+		}
+		return 0;
+	}
+
+private:
+	template <typename T>
+	range<T> get_range(const table& t, std::uint32_t first, std::uint32_t count) const
+	{
+		const T* b = reinterpret_cast<const T*>(m_data + t.offset);
+		if (first > t.count || count > t.count - first) {
+			return range<T>(b, b);
+		}
+		return range<T>(b + first, b + first + count);
+	}
+
+	bool validate_table(const table& t, std::size_t record_size) const
+	{
+		return t.offset <= m_size && t.count <= (m_size - t.offset) / record_size &&
+		       0 == t.offset % sizeof(std::uint32_t);
+	}
+
+	bool validate() const
+	{
+		const header& h = get_header();
+		return 0 == std::memcmp(h.magic, magic, sizeof(magic)) && version == h.version &&
+		       h.size == m_size &&
+		       validate_table(h.classes, sizeof(class_record)) &&
+		       validate_table(h.bases, sizeof(base_record)) &&
+		       validate_table(h.methods, sizeof(method_record)) &&
+		       validate_table(h.params, sizeof(param_record)) &&
+		       validate_table(h.fields, sizeof(field_record)) &&
+		       h.strings.offset <= m_size && h.strings.count <= m_size - h.strings.offset &&
+		       0 != h.strings.count && '\0' == m_data[h.strings.offset + h.strings.count - 1];
+	}
+
+private:
+	reader(const reader&);
+	reader& operator =(const reader&);
+
+private:
+	const char* m_data;
+	std::size_t m_size;
+}; // class reader
+
+} // namespace metadata
+} // namespace reflector
+
+#endif // METADATA_READER_HPP
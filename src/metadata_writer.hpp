@@ -0,0 +1,188 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef METADATA_WRITER_HPP
+#define METADATA_WRITER_HPP
+
+#include "debug.hpp"
+#include "metadata_format.hpp"
+#include "model.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace reflector {
+
+// @class metadata_writer
+// @brief Serializes model of reflected classes in binary format of
+//        metadata_format.hpp.
+class metadata_writer
+{
+private:
+	typedef std::map<std::string, std::uint32_t> string_to_offset;
+public:
+	metadata_writer()
+	{
+		intern("");
+	}
+
+	void add(const model::unit::records& reflected)
+	{
+		std::vector<const model::record*> sorted;
+		for (auto& c : reflected) {
+			sorted.push_back(&c);
+		}
+		std::stable_sort(sorted.begin(), sorted.end(),
+			[](const model::record* c1, const model::record* c2)
+			{
+				return c1->qualified_name < c2->qualified_name;
+			}
+		);
+		for (auto c : sorted) {
+			add(*c);
+		}
+	}
+
+	//@brief Gets content of metadata file.
+	void serialize(std::string& data) const
+	{
+		metadata::header h = {};
+		std::memcpy(h.magic, metadata::magic, sizeof(h.magic));
+		h.version = metadata::version;
+		data.assign(sizeof(h), '\0');
+		append_table(data, h.classes, m_classes);
+		append_table(data, h.bases, m_bases);
+		append_table(data, h.methods, m_methods);
+		append_table(data, h.params, m_params);
+		append_table(data, h.fields, m_fields);
+		h.strings.offset = data.size();
+		h.strings.count = m_strings.size();
+		data += m_strings;
+		h.size = data.size();
+		std::memcpy(&data[0], &h, sizeof(h));
+	}
+
+private:
+	void add(const model::record& c)
+	{
+		metadata::class_record r = {};
+		r.name = intern(c.name);
+		r.qualified_name = intern(c.qualified_name);
+		r.kind = intern(c.kind);
+		r.traits = get_traits(c);
+		r.size = c.size;
+		r.alignment = c.alignment;
+		r.first_base = m_bases.size();
+		for (auto& b : c.bases) {
+			metadata::base_record br = {};
+			br.name = intern(b.name);
+			br.access = b.access;
+			br.flags = b.is_virtual ? metadata::flag_virtual : 0;
+			m_bases.push_back(br);
+		}
+		r.base_count = m_bases.size() - r.first_base;
+		r.first_method = m_methods.size();
+		for (auto& m : c.methods) {
+			metadata::method_record mr = {};
+			mr.name = intern(m.name);
+			mr.return_type = intern(m.return_type);
+			mr.flags = m.is_const ? metadata::flag_const : 0;
+			mr.first_param = m_params.size();
+			for (auto& t : m.param_types) {
+				metadata::param_record pr = {};
+				pr.type = intern(t);
+				m_params.push_back(pr);
+			}
+			mr.param_count = m_params.size() - mr.first_param;
+			m_methods.push_back(mr);
+		}
+		r.method_count = m_methods.size() - r.first_method;
+		r.first_field = m_fields.size();
+		for (auto& f : c.fields) {
+			if (!f.is_selected) {
+				continue;
+			}
+			metadata::field_record fr = {};
+			fr.name = intern(f.name);
+			fr.type = intern(f.type);
+			fr.access = f.access;
+			fr.flags = f.is_bit_field ? metadata::flag_bit_field : 0;
+			fr.offset = f.offset;
+			fr.size = f.size;
+			fr.alignment = f.alignment;
+			m_fields.push_back(fr);
+		}
+		r.field_count = m_fields.size() - r.first_field;
+		m_classes.push_back(r);
+	}
+
+	static std::uint32_t get_traits(const model::record& c)
+	{
+		static const std::pair<model::trait, metadata::trait> traits[] = {
+			{ model::trait_abstract, metadata::trait_abstract },
+			{ model::trait_polymorphic, metadata::trait_polymorphic },
+			{ model::trait_aggregate, metadata::trait_aggregate },
+			{ model::trait_union, metadata::trait_union },
+			{ model::trait_empty, metadata::trait_empty },
+			{ model::trait_trivial, metadata::trait_trivial },
+			{ model::trait_trivially_copyable, metadata::trait_trivially_copyable },
+			{ model::trait_standard_layout, metadata::trait_standard_layout },
+			{ model::trait_pod, metadata::trait_pod },
+			{ model::trait_default_constructor, metadata::trait_default_constructor }
+		};
+		std::uint32_t t = 0;
+		for (auto& i : traits) {
+			t |= c.has(i.first) ? i.second : 0;
+		}
+		return t;
+	}
+
+	//@brief Adds string to string table once.
+	//@return offset of string in string table.
+	std::uint32_t intern(const std::string& s)
+	{
+		string_to_offset::const_iterator i = m_offsets.find(s);
+		if (i != m_offsets.end()) {
+			return i->second;
+		}
+		const std::uint32_t offset = m_strings.size();
+		m_strings.append(s.c_str(), s.size() + 1);
+		m_offsets.insert(std::make_pair(s, offset));
+		return offset;
+	}
+
+	template <typename Record>
+	static void append_table(std::string& data, metadata::table& t, const std::vector<Record>& records)
+	{
+		t.offset = data.size();
+		t.count = records.size();
+		if (!records.empty()) {
+			data.append(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(Record));
+		}
+	}
+
+private:
+	std::vector<metadata::class_record> m_classes;
+	std::vector<metadata::base_record> m_bases;
+	std::vector<metadata::method_record> m_methods;
+	std::vector<metadata::param_record> m_params;
+	std::vector<metadata::field_record> m_fields;
+	std::string m_strings;
+	string_to_offset m_offsets;
+}; // class metadata_writer
+
+} // namespace reflector
+
+#endif // METADATA_WRITER_HPP
@@ -0,0 +1,370 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef MODEL_HPP
+#define MODEL_HPP
+
+#include "metadata_format.hpp"
+
+#include <cstdint>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+// @note: Everything outputs are rendered from, extracted from AST once.
+//        It does not refer to clang, so it is serialized into cache and
+//        rendered again in other flavour without parsing input.
+namespace reflector {
+namespace model {
+
+typedef std::vector<std::string> strings;
+
+enum trait {
+	trait_abstract = 1 << 0,
+	trait_polymorphic = 1 << 1,
+	trait_aggregate = 1 << 2,
+	trait_union = 1 << 3,
+	trait_empty = 1 << 4,
+	trait_trivial = 1 << 5,
+	trait_trivially_copyable = 1 << 6,
+	trait_standard_layout = 1 << 7,
+	trait_pod = 1 << 8,
+	trait_default_constructor = 1 << 9,
+	trait_any_dependent_bases = 1 << 10,
+	trait_friends = 1 << 11,
+	trait_user_declared_constructor = 1 << 12,
+	trait_user_declared_copy_assignment = 1 << 13,
+	trait_user_declared_destructor = 1 << 14,
+	trait_user_provided_default_constructor = 1 << 15,
+	trait_template_decl = 1 << 16,
+	//@brief Equal objects have equal bytes.
+	trait_unique_representation = 1 << 17,
+	//@brief Declared final, nothing derives from it.
+	trait_final = 1 << 18,
+	//@brief Has polymorphic base, so shares its virtual table pointer.
+	trait_polymorphic_base = 1 << 19,
+	//@brief Specialization of class template, its names have arguments.
+	trait_template_specialization = 1 << 20
+};
+
+//@brief Kind of field which threads write concurrently.
+enum sync_kind {
+	sync_none,
+	sync_atomic,
+	//@brief Mutex, condition variable or other lock.
+	sync_lock,
+	//@brief Marked by __attribute__((annotate("per_thread"))).
+	sync_per_thread
+};
+
+// @struct method
+// @brief Public non static method which invoke dispatches to.
+struct method
+{
+	std::string name;
+	std::string return_type;
+	strings param_types;
+	bool is_const;
+}; // struct method
+
+// @struct virtual_method
+// @brief Virtual method of any access, except destructor.
+struct virtual_method
+{
+	//@brief Name, parameter types and const, e.g. "f(int) const".
+	std::string signature;
+	bool is_pure;
+	//@brief Overridden methods as '<qualified class name>::<signature>'.
+	strings overrides;
+}; // struct virtual_method
+
+// @struct field
+struct field
+{
+	std::string name;
+	std::string type;
+	metadata::access access;
+	bool is_bit_field;
+	//@brief Offset in bytes, bit field offset is rounded down.
+	unsigned offset;
+	//@brief Size in bytes, bytes occupied by bit field.
+	unsigned size;
+	unsigned alignment;
+	//@brief Marked by __attribute__((annotate("hot"))), often accessed.
+	bool is_hot;
+	sync_kind sync;
+	//@brief Reflected by selection, layout of other fields is kept for
+	//       layout and false sharing reports.
+	bool is_selected;
+}; // struct field
+
+// @struct base
+struct base
+{
+	//@brief Type as written.
+	std::string name;
+	//@brief Qualified name of class, as record of that class has it.
+	std::string qualified_name;
+	metadata::access access;
+	bool is_virtual;
+}; // struct base
+
+// @struct subobject
+// @brief Part of record which is not its field: pointer to virtual table
+//        or base class, including indirect virtual bases.
+struct subobject
+{
+	std::string name;
+	unsigned offset;
+	unsigned size;
+}; // struct subobject
+
+// @struct record
+// @brief Reflected class, struct or union.
+struct record
+{
+	typedef std::vector<base> bases_type;
+	typedef std::vector<method> methods_type;
+	typedef std::vector<field> fields_type;
+	typedef std::vector<subobject> subobjects_type;
+	typedef std::vector<virtual_method> virtual_methods_type;
+
+	bool has(trait t) const
+	{
+		return 0 != (traits & t);
+	}
+
+	//@brief "class", "struct" or "union".
+	std::string kind;
+	std::string name;
+	std::string qualified_name;
+	//@brief Name returned by std::type_info::name.
+	std::string type_name;
+	//@brief Qualified name of class template of instantiation, empty for
+	//       other classes, explicit specializations included.
+	std::string template_name;
+	//@brief Parameters and arguments of partial specialization matching
+	//       all instantiations, e.g. "typename T, int N" and "T, N", empty
+	//       when they can not be written.
+	std::string template_parameters;
+	std::string template_arguments;
+	unsigned size;
+	unsigned alignment;
+	unsigned num_virtual_bases;
+	std::uint32_t traits;
+	bases_type bases;
+	methods_type methods;
+	fields_type fields;
+	//@brief Non field parts in order of offset.
+	subobjects_type subobjects;
+	virtual_methods_type virtual_methods;
+}; // struct record
+
+// @struct enumeration
+struct enumeration
+{
+	typedef std::pair<long long, std::string> enumerator;
+	typedef std::vector<enumerator> enumerators;
+
+	std::string name;
+	std::string qualified_name;
+	std::string type_name;
+	//@brief Values and names in order of declaration.
+	enumerators values;
+}; // struct enumeration
+
+// @struct unit
+// @brief Reflected types of one input file in order of declaration.
+struct unit
+{
+	typedef std::vector<record> records;
+	typedef std::vector<enumeration> enumerations;
+
+	records classes;
+	enumerations enums;
+}; // struct unit
+
+const char* get_magic()
+{
+	return "greflect model 6";
+}
+
+// @note: Text format: magic line, then count line and lines of each
+//        record and enumeration. Strings take whole line, numbers of one
+//        object share line.
+void serialize(const unit& u, std::string& data)
+{
+	std::ostringstream out;
+	out << get_magic() << "\n" << u.classes.size() << "\n";
+	for (auto& r : u.classes) {
+		out << r.kind << "\n" << r.name << "\n" << r.qualified_name << "\n" << r.type_name << "\n";
+		out << r.template_name << "\n" << r.template_parameters << "\n" << r.template_arguments << "\n";
+		out << r.size << " " << r.alignment << " " << r.num_virtual_bases << " " << r.traits << "\n";
+		out << r.bases.size() << "\n";
+		for (auto& b : r.bases) {
+			out << b.access << " " << b.is_virtual << "\n" << b.name << "\n" << b.qualified_name << "\n";
+		}
+		out << r.methods.size() << "\n";
+		for (auto& m : r.methods) {
+			out << m.is_const << " " << m.param_types.size() << "\n" << m.name << "\n" << m.return_type << "\n";
+			for (auto& t : m.param_types) {
+				out << t << "\n";
+			}
+		}
+		out << r.fields.size() << "\n";
+		for (auto& f : r.fields) {
+			out << f.access << " " << f.is_bit_field << " " << f.offset << " " << f.size << " " << f.alignment
+			    << " " << f.is_hot << " " << f.sync << " " << f.is_selected << "\n";
+			out << f.name << "\n" << f.type << "\n";
+		}
+		out << r.subobjects.size() << "\n";
+		for (auto& o : r.subobjects) {
+			out << o.offset << " " << o.size << "\n" << o.name << "\n";
+		}
+		out << r.virtual_methods.size() << "\n";
+		for (auto& v : r.virtual_methods) {
+			out << v.is_pure << " " << v.overrides.size() << "\n" << v.signature << "\n";
+			for (auto& o : v.overrides) {
+				out << o << "\n";
+			}
+		}
+	}
+	out << u.enums.size() << "\n";
+	for (auto& e : u.enums) {
+		out << e.name << "\n" << e.qualified_name << "\n" << e.type_name << "\n" << e.values.size() << "\n";
+		for (auto& v : e.values) {
+			out << v.first << " " << v.second << "\n";
+		}
+	}
+	data = out.str();
+}
+
+//@brief Reads numbers line.
+bool read_count(std::istream& in, std::size_t& count)
+{
+	return (in >> count) && '\n' == in.get();
+}
+
+bool read_access(std::istream& in, metadata::access& a)
+{
+	unsigned v = 0;
+	if (!(in >> v) || metadata::access_none < v) {
+		return false;
+	}
+	a = static_cast<metadata::access>(v);
+	return true;
+}
+
+//@brief Parses data of serialize.
+//@return false if data is not model of this version.
+bool parse(const std::string& data, unit& u)
+{
+	std::istringstream in(data);
+	std::string line;
+	std::size_t count = 0;
+	if (!std::getline(in, line) || line != get_magic() || !read_count(in, count)) {
+		return false;
+	}
+	u.classes.resize(count);
+	for (auto& r : u.classes) {
+		if (!std::getline(in, r.kind) || !std::getline(in, r.name) ||
+		    !std::getline(in, r.qualified_name) || !std::getline(in, r.type_name) ||
+		    !std::getline(in, r.template_name) || !std::getline(in, r.template_parameters) ||
+		    !std::getline(in, r.template_arguments) ||
+		    !(in >> r.size >> r.alignment >> r.num_virtual_bases >> r.traits) || !read_count(in, count)) {
+			return false;
+		}
+		r.bases.resize(count);
+		for (auto& b : r.bases) {
+			if (!read_access(in, b.access) || !(in >> b.is_virtual) || '\n' != in.get() ||
+			    !std::getline(in, b.name) || !std::getline(in, b.qualified_name)) {
+				return false;
+			}
+		}
+		if (!read_count(in, count)) {
+			return false;
+		}
+		r.methods.resize(count);
+		for (auto& m : r.methods) {
+			if (!(in >> m.is_const) || !read_count(in, count) ||
+			    !std::getline(in, m.name) || !std::getline(in, m.return_type)) {
+				return false;
+			}
+			m.param_types.resize(count);
+			for (auto& t : m.param_types) {
+				if (!std::getline(in, t)) {
+					return false;
+				}
+			}
+		}
+		if (!read_count(in, count)) {
+			return false;
+		}
+		r.fields.resize(count);
+		for (auto& f : r.fields) {
+			unsigned sync = 0;
+			if (!read_access(in, f.access) ||
+			    !(in >> f.is_bit_field >> f.offset >> f.size >> f.alignment >> f.is_hot >> sync >> f.is_selected) ||
+			    sync_per_thread < sync || '\n' != in.get() ||
+			    !std::getline(in, f.name) || !std::getline(in, f.type)) {
+				return false;
+			}
+			f.sync = static_cast<sync_kind>(sync);
+		}
+		if (!read_count(in, count)) {
+			return false;
+		}
+		r.subobjects.resize(count);
+		for (auto& o : r.subobjects) {
+			if (!(in >> o.offset >> o.size) || '\n' != in.get() || !std::getline(in, o.name)) {
+				return false;
+			}
+		}
+		if (!read_count(in, count)) {
+			return false;
+		}
+		r.virtual_methods.resize(count);
+		for (auto& v : r.virtual_methods) {
+			if (!(in >> v.is_pure) || !read_count(in, count) || !std::getline(in, v.signature)) {
+				return false;
+			}
+			v.overrides.resize(count);
+			for (auto& o : v.overrides) {
+				if (!std::getline(in, o)) {
+					return false;
+				}
+			}
+		}
+	}
+	if (!read_count(in, count)) {
+		return false;
+	}
+	u.enums.resize(count);
+	for (auto& e : u.enums) {
+		if (!std::getline(in, e.name) || !std::getline(in, e.qualified_name) ||
+		    !std::getline(in, e.type_name) || !read_count(in, count)) {
+			return false;
+		}
+		e.values.resize(count);
+		for (auto& v : e.values) {
+			if (!(in >> v.first) || ' ' != in.get() || !std::getline(in, v.second)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+} // namespace model
+} // namespace reflector
+
+#endif // MODEL_HPP
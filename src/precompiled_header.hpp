@@ -0,0 +1,200 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef PRECOMPILED_HEADER_HPP
+#define PRECOMPILED_HEADER_HPP
+
+#include "cache.hpp"
+#include "invocation.hpp"
+#include "messenger.hpp"
+#include "utils.hpp"
+
+#include <clang/Frontend/CompilerInstance.h>
+#include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/FrontendOptions.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+
+#include <ctime>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace reflector {
+
+// @class precompiled_header
+// @brief Common header precompiled once per set of compiler arguments and
+//        loaded by every generator instead of parsing it again. With cache
+//        it is kept in cache directory and reused by later runs while the
+//        files it was built from are unchanged, otherwise it lives in
+//        temporary file until the end of run. File with '.pch' extension
+//        is taken as already built.
+class precompiled_header
+{
+public:
+	typedef std::shared_ptr<precompiled_header> ptr;
+	typedef std::vector<std::string> strings;
+
+	// @struct built
+	struct built
+	{
+		std::string file_name;
+		//@brief Files it was built from, generated outputs depend on them.
+		cache::entry::dependencies dependencies;
+		//@brief Clang checks modification times of files of given '.pch',
+		//       ones built here are checked by content.
+		bool validate;
+	}; // struct built
+private:
+	typedef std::map<std::string, built> arguments_to_built;
+public:
+	precompiled_header(const std::string& header, const cache::ptr& c)
+		: m_header(header)
+		, m_cache(c)
+	{
+		if (!llvm::sys::fs::exists(header)) {
+			throw std::runtime_error("Can not open precompiled header '" + header + "'");
+		}
+	}
+
+	~precompiled_header()
+	{
+		for (auto& t : m_temporaries) {
+			llvm::sys::fs::remove(t);
+		}
+	}
+
+	const std::string& get_header() const
+	{
+		return m_header;
+	}
+
+	//@brief Gets precompiled header for given arguments, builds it first
+	//       time and again when one of its files changes. Generators of
+	//       different threads wait for one build.
+	built get(const invocation::arguments& args)
+	{
+		if (llvm::sys::path::extension(m_header) == ".pch") {
+			built b;
+			b.file_name = m_header;
+			b.dependencies.push_back(make_dependency(m_header));
+			b.validate = true;
+			return b;
+		}
+		std::string key = m_header;
+		for (auto& a : args) {
+			key += '\0';
+			key += a;
+		}
+		std::lock_guard<std::mutex> lock(m_mutex);
+		arguments_to_built::const_iterator i = m_built.find(key);
+		if (i != m_built.end() && is_unchanged(i->second)) {
+			return i->second;
+		}
+		built b;
+		b.validate = false;
+		if (0 == m_cache) {
+			if (i != m_built.end()) {
+				b.file_name = i->second.file_name;
+			} else {
+				llvm::SmallString<256> temp;
+				if (llvm::sys::fs::createTemporaryFile("greflect", "pch", temp)) {
+					throw std::runtime_error("Can not create temporary precompiled header");
+				}
+				m_temporaries.push_back(temp.str());
+				b.file_name = temp.str();
+			}
+			const std::time_t start = std::time(0);
+			build(args, b);
+			for (auto& d : b.dependencies) {
+				cache::update(d, start);
+			}
+		} else {
+			strings parts(1, "pch");
+			parts.push_back(m_header);
+			parts.insert(parts.end(), args.begin(), args.end());
+			const std::string cache_key = m_cache->get_key(parts);
+			b.file_name = m_cache->get_file_name(cache_key, ".pch");
+			cache::entry e;
+			if (!m_cache->find(cache_key, e) || !llvm::sys::fs::exists(b.file_name)) {
+				const std::time_t start = std::time(0);
+				build(args, b);
+				e = cache::entry();
+				e.files = b.dependencies;
+				m_cache->store(cache_key, e, start);
+			}
+			b.dependencies = e.files;
+		}
+		m_built[key] = b;
+		return b;
+	}
+
+private:
+	static cache::dependency make_dependency(const std::string& file_name)
+	{
+		cache::dependency d = {};
+		d.file_name = file_name;
+		return d;
+	}
+
+	static bool is_unchanged(const built& b)
+	{
+		for (auto& d : b.dependencies) {
+			if (!cache::is_unchanged(d)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void build(const invocation::arguments& args, built& b) const
+	{
+		clang::CompilerInstance compiler;
+		compiler.createDiagnostics();
+		clang::CompilerInvocation* i = invocation::create(args, m_header, compiler.getDiagnostics());
+		clang::FrontendOptions& f = i->getFrontendOpts();
+		f.ProgramAction = clang::frontend::GeneratePCH;
+		f.SkipFunctionBodies = true;
+		f.OutputFile = b.file_name;
+		f.Inputs.clear();
+		f.Inputs.push_back(clang::FrontendInputFile(m_header, clang::IK_CXX));
+		compiler.setInvocation(i);
+		clang::GeneratePCHAction action;
+		if (!compiler.ExecuteAction(action) || compiler.getDiagnostics().hasErrorOccurred()) {
+			throw std::runtime_error("Can not precompile header '" + m_header + "'");
+		}
+		strings names;
+		if (compiler.hasSourceManager()) {
+			utils::get_file_names(compiler.getSourceManager(), names);
+		} else {
+			names.push_back(m_header);
+		}
+		b.dependencies.clear();
+		for (auto& n : names) {
+			b.dependencies.push_back(make_dependency(n));
+		}
+		massenger::print("Precompile header " + m_header + " to " + b.file_name);
+	}
+
+private:
+	std::string m_header;
+	cache::ptr m_cache;
+	std::mutex m_mutex;
+	arguments_to_built m_built;
+	strings m_temporaries;
+}; // class precompiled_header
+
+} // namespace reflector
+
+#endif // PRECOMPILED_HEADER_HPP
@@ -0,0 +1,124 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef PROFILE_HPP
+#define PROFILE_HPP
+
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace reflector {
+
+// @class profile
+// @brief Method call counts used to order generated dispatch.
+//        The file has one "<name> <count>" pair per line, where name is
+//        either "Class::method" or just "method". Lines starting with '#'
+//        are ignored. The format is the same that generated code dumps
+//        with reflect_profile::dump when compiled with REFLECT_PROFILE.
+class profile
+{
+public:
+	typedef std::pair<unsigned long, std::string> hit;
+	typedef std::vector<hit> hits;
+private:
+	typedef std::map<std::string, unsigned long> name_to_count;
+public:
+	//@brief Maximal number of methods in fast path of one invoke.
+	static unsigned hot_limit()
+	{
+		return 4;
+	}
+
+	bool empty() const
+	{
+		return m_counts.empty();
+	}
+
+	//@brief Gets name of loaded file, empty if nothing is loaded.
+	const std::string& get_file_name() const
+	{
+		return m_file_name;
+	}
+
+	void load(const std::string& file_name)
+	{
+		m_file_name = file_name;
+		std::ifstream in(file_name.c_str());
+		if (!in) {
+			throw std::runtime_error("Can not open profile file '" + file_name + "'");
+		}
+		std::string line;
+		while (std::getline(in, line)) {
+			const std::string::size_type b = line.find_first_not_of(" \t\r");
+			if (std::string::npos == b || '#' == line[b]) {
+				continue;
+			}
+			// @note: Name of instantiation has spaces, e.g.
+			//        'ns::map<int, double>::find 5', count is the last word.
+			const std::string::size_type e = line.find_last_not_of(" \t\r") + 1;
+			const std::string::size_type c = line.find_last_of(" \t", e - 1);
+			std::istringstream s(std::string::npos == c || c < b ? "" : line.substr(c + 1, e - c - 1));
+			unsigned long count = 0;
+			if (!(s >> count) || !s.eof()) {
+				throw std::runtime_error("Invalid line in profile file '" + file_name + "': " + line);
+			}
+			const std::string::size_type n = line.find_last_not_of(" \t", c) + 1;
+			m_counts[line.substr(b, n - b)] += count;
+		}
+	}
+
+	//@brief Gets call count of method.
+	//@param c qualified name of class
+	//@param m name of method
+	unsigned long get_count(const std::string& c, const std::string& m) const
+	{
+		name_to_count::const_iterator i = m_counts.find(c + "::" + m);
+		if (i != m_counts.end()) {
+			return i->second;
+		}
+		i = m_counts.find(m);
+		return i == m_counts.end() ? 0 : i->second;
+	}
+
+	//@brief Selects the hottest methods from given names, hottest first.
+	template <typename Names>
+	void get_hot(const std::string& c, const Names& names, hits& hs) const
+	{
+		for (auto n : names) {
+			const unsigned long count = get_count(c, n);
+			if (0 != count) {
+				hs.push_back(std::make_pair(count, n));
+			}
+		}
+		std::stable_sort(hs.begin(), hs.end(),
+			[](const hit& h1, const hit& h2)
+			{
+				return h1.first > h2.first;
+			}
+		);
+		if (hs.size() > hot_limit()) {
+			hs.resize(hot_limit());
+		}
+	}
+
+private:
+	std::string m_file_name;
+	name_to_count m_counts;
+}; // class profile
+
+} // namespace reflector
+
+#endif // PROFILE_HPP
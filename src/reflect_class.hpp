@@ -1,572 +1,928 @@
-/*
-* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
-* Permission is hereby granted, free of charge, to any person obtaining a copy
-* of this software and associated documentation files (the "Software"), to deal
-* in the Software without restriction, including without limitation the rights
-* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-* copies of the Software, and to permit persons to whom the Software is
-* furnished to do so, subject to the following conditions:
-*/
-
-#ifndef REFLECTED_CLASS_HPP
-#define REFLECTED_CLASS_HPP
-
-#include "debug.hpp"
-#include "utils.hpp"
-
-#include <clang/AST/Decl.h>
-#include <clang/AST/DeclCXX.h>
-#include <clang/Basic/Specifiers.h>
-#include <llvm/Support/raw_ostream.h>
-
-#include <string>
-#include <sstream>
-#include <set>
-
-// @class method_info
-class method_info
-{
-public:
-	class signature_comparator
-	{
-	public:
-		bool operator ()(const method_info& i1, const method_info& i2) const
-		{
-			if (i1.get_params_count() == i2.get_params_count()) {
-				const std::string& k1 = i1.get_key();
-				const std::string& k2 = i2.get_key();
-				return i1.is_const() < i2.is_const() || k1.size() < k2.size() || k1 < k2;
-			}
-			return i1.get_params_count() < i2.get_params_count();
-		}
-	};
-
-	typedef clang::CXXMethodDecl method;
-	typedef std::set<std::string> method_names;
-public:
-	explicit method_info(method* m)
-		: m_method(m)
-		, m_return_type(extract_return_type())
-		, m_param_types(exctrat_param_type_list())
-		, m_forward_arguments(extract_forward_arguments())
-		, m_signature(extract_signature())
-	{
-	}
-
-	static const std::string get_type_def()
-	{
-		static std::string def = "FuncPtrToClassMethod";
-		return def;
-	}
-
-	const std::string& get_signture() const
-	{
-		return m_signature;
-	}
-
-	const std::string& get_key() const
-	{
-		return m_signature;
-	}
-
-	const std::string& get_param_type_list() const
-	{
-		return m_param_types;
-	}
-
-	const std::string& get_forward_arguments() const
-	{
-		return m_forward_arguments;
-	}
-
-	const std::string& get_return_type() const
-	{
-		return m_return_type;
-	}
-
-	unsigned get_params_count() const
-	{
-		ASSERT(0 != m_method);
-		return m_method->getNumParams();
-	}
-
-	bool is_const() const
-	{
-		ASSERT(0 != m_method);
-		return m_method->isConst();
-	}
-
-	bool has_param() const
-	{
-		return 0 < get_params_count();
-	}
-
-	bool non_void_return_type() const
-	{
-		return m_return_type != "void";
-	}
-private:
-	std::string extract_signature() const
-	{
-		ASSERT(0 != m_method);
-		std::string res = get_return_type() + " (Type::*" + get_type_def() + ")(";
-		method::param_const_iterator b = m_method->param_begin();
-		method::param_const_iterator e = m_method->param_end();
-		while ( b != e ) {
-			ASSERT(0 != *b);
-			res += (*b)->getType().getAsString();
-			if (++b != e) {
-				res += ", ";
-			}
-		}
-		res += is_const() ? ") const" : ")";
-		utils::replace(res, "_Bool", "bool");
-		return res;
-	}
-
-	std::string extract_return_type() const
-	{
-		ASSERT(0 != m_method);
-		std::string res = m_method->getReturnType().getAsString();
-		utils::replace(res, "_Bool", "bool");
-		return res;
-	}
-
-	std::string exctrat_param_type_list() const
-	{
-		ASSERT(0 != m_method);
-		std::string res;
-		method::param_const_iterator b = m_method->param_begin();
-		method::param_const_iterator e = m_method->param_end();
-		unsigned idx = 0;
-		while (b != e) {
-			res += (*b)->getType().getAsString() + " p" + std::to_string(++idx);
-			if (++b != e) {
-				res += ", ";
-			}
-		}
-		utils::replace(res, "_Bool", "bool");
-		return res;
-	}
-
-	std::string extract_forward_arguments() const
-	{
-		typedef std::vector<std::string> Strings;
-		Strings params;
-		utils::split(m_param_types, params, ", ");
-		std::string res;
-		Strings::const_iterator b = params.begin();
-		Strings::const_iterator e = params.end();
-		while( b != e ) {
-			std::string::const_reverse_iterator i = std::find(b->rbegin(), b->rend(), ' ');
-			ASSERT(i != b->rend());
-			const unsigned pos = b->rend() - i;
-			res += "std::forward<" + b->substr(0, pos - 1) + ">(" + b->substr(pos, b->size()) + ")";
-			if (++b != e) {
-				res += ", ";
-			}
-		}
-		return res;
-	}
-
-	//@TODO implement
-	//void keep_code_stile(std::string& str, unsigned count) const
-	//{
-	//	if (0 == count) {
-	//		return;
-	//	}
-	//	std::string::size_type pos = count;
-	//	std::string tab = "\n\t\t\t\t";
-	//	while (str.size() > pos && (pos = str.find(',', pos)) != std::string::npos) {
-	//		str.insert(pos + 1, tab);
-	//		pos += count - (tab.size() / 2 - 3) * (count / 10);
-	//		tab += "\t";
-	//	}
-	//}
-
-private:
-	method* m_method;
-	std::string m_return_type;
-	std::string m_param_types;
-	std::string m_forward_arguments;
-	std::string m_signature;
-}; // class method_info
-
-//@class invoke_output
-class invoke_output
-{
-private:
-	typedef method_info::method method;
-	typedef method_info::method_names method_names;
-	typedef std::map<method_info, method_names, method_info::signature_comparator> methods_map;
-public:
-	invoke_output(clang::CXXRecordDecl::method_range r)
-	{
-		init(r);
-	}
-public:
-
-	bool has_methods() const
-	{
-		return !m_methods_map.empty();
-	}
-
-	void get_methods(method_names& ns) const
-	{
-		for (auto i : m_methods_map) {
-			ns.insert(i.second.begin(), i.second.end());
-		}
-	}
-
-	void dump(clang::raw_ostream& out) const
-	{
-		for (auto i : m_methods_map) {
-			 dump(out, i.first, i.second);
-		}
-	}
-
-private:
-	void init(clang::CXXRecordDecl::method_range r)
-	{
-		for (clang::CXXRecordDecl::method_iterator i = r.begin(); i != r.end(); ++i) {
-			method* m = *i;
-			ASSERT(0 != m);
-			if (supported(m)) {
-				m_methods_map[method_info(m)].insert(m->getNameAsString());
-			}
-		}
-	}
-
-	bool supported(method* m) const
-	{
-		ASSERT(0 != m);
-		return !m->isStatic() && m->isUserProvided() && clang::Decl::Kind::CXXMethod == m->getKind() &&
-	                m->getAccess() == clang::AccessSpecifier::AS_public && !m->isDefaulted() &&
-	               !m->isCopyAssignmentOperator() && !m->isMoveAssignmentOperator();
-	}
-
-	void dump(clang::raw_ostream& out, const method_info& info, const method_names& names) const
-	{
-		ASSERT(!names.empty());
-		std::string const_qualifier = info.is_const() ? "const " : "";
-		out << "\tstatic " << info.get_return_type() << " invoke(" << const_qualifier << "Type & o, const char * n";
-		if (info.has_param()) {
-			out << ", " + info.get_param_type_list();
-		}
-		out << ") " << "\n\t{\n";
-		out << "\t\ttypedef " << info.get_signture() << ";\n";
-		out << "\t\ttypedef std::map<std::string, " << method_info::get_type_def() << "> funcMap;\n";
-		out << "\t\tstatic funcMap f_map;\n";
-		out << "\t\tif (f_map.empty()) {\n";
-		for (auto i : names) {
-			out << "\t\t\tf_map.insert(std::make_pair(\"" << i << "\", &Type::" << i << "));\n";
-		}
-		out << "\t\t}\n\t\tfuncMap::const_iterator found = f_map.find(n);\n";
-		out << "\t\tif(found == f_map.end()) {\n";
-		out << "\t\t\tthrow std::runtime_error(\"Function with name '\" + std::string(n) + \"' not found\");\n\t\t}\n";
-		out << "\t\t";
-		if (info.non_void_return_type()) {
-			out << "return ";
-		}
-		out << "(o.*found->second)(" << info.get_forward_arguments() <<  ");\n\t}\n\n";
-	}
-
-private:
-	methods_map m_methods_map;
-}; // class invoke_output
-
-//@class reflected_class
-class reflected_class
-{
-private:
-	typedef clang::CXXRecordDecl source_class;
-public:
-	typedef std::shared_ptr<reflected_class> ptr;
-	typedef std::list<ptr> reflected_collection;
-public:
-	reflected_class(source_class* d)
-		: m_source_class(d)
-		, m_methods(d->methods())
-	{
-		ASSERT(d->isClass());
-		ASSERT(d->hasDefinition()); 
-	}
-
-	std::string get_qualified_name() const
-	{
-		return m_source_class->getQualifiedNameAsString();
-	}
-
-	std::string get_name() const
-	{
-		return m_source_class->getNameAsString();
-	}
-
-	int get_num_bases() const
-	{
-		return m_source_class->getNumBases();
-	}
-
-	bool has_any_dependent_bases() const
-	{
-		return m_source_class->hasAnyDependentBases();
-	}
-
-	bool has_friends() const
-	{
-		return m_source_class->hasFriends();
-	}
-
-	bool has_user_declared_constructor() const
-	{
-		return m_source_class->hasUserDeclaredConstructor();
-	}
-
-	bool has_user_declared_copy_assignment() const
-	{
-		return m_source_class->hasUserDeclaredCopyAssignment();
-	}
-
-	bool has_user_declared_destructor() const
-	{
-		return m_source_class->hasUserDeclaredDestructor();
-	}
-
-	bool has_user_provided_default_constructor() const
-	{
-		return m_source_class->hasUserProvidedDefaultConstructor();
-	}
-
-	bool is_aggregate() const
-	{
-		return m_source_class->isAggregate();
-	}
-
-	bool is_derived_from(const std::string& base_name) const
-	{
-		static method_info::method_names names;
-		if (names.empty()) {
-			get_base_names(names);
-		}
-		return names.find("class " + base_name) != names.end();
-	}
-
-	bool is_template_decl() const
-	{
-		return m_source_class->isTemplateDecl();
-	}
-
-	bool is_polymorphic() const
-	{
-		return m_source_class->isPolymorphic();
-	}
-
-	int get_num_virtual_bases() const
-	{
-		return m_source_class->getNumVBases();
-	}
-
-	bool is_abstract() const
-	{
-		return m_source_class->isAbstract();
-	}
-
-	bool has_default_constructor() const
-	{
-		return m_source_class->hasDefaultConstructor();
-	}
-
-	void get_base_names(method_info::method_names& names) const
-	{
-		source_class::base_class_iterator b = m_source_class->bases_begin();
-		source_class::base_class_iterator e = m_source_class->bases_end();
-		for (; b != e; ++b) {
-			names.insert(b->getType().getAsString());
-		}
-	}
- 
-	void dump(clang::raw_ostream& out) const
-	{
-		dump_begin_specalization(out);
-		dump_create(out);
-		dump_get_name(out);
-		dump_get_qualified_name(out);
-		dump_get_base_names(out);
-		dump_get_num_bases(out);
-		dump_get_num_virtual_bases(out);
-		dump_get_methods(out);
-		dump_has_default_constructor(out);
-		dump_has_any_dependent_bases(out);
-		dump_has_friends(out);
-		dump_has_user_declared_constructor(out);
-		dump_has_user_declared_copy_assignment(out);
-		dump_has_user_declared_destructor(out);
-		dump_has_user_provided_default_constructor(out);
-		dump_is_aggregate(out);
-		dump_is_derived_from(out);
-		dump_is_template_decl(out);
-		dump_is_abstract(out);
-		dump_is_polymorphic(out);
-		dump_invokes(out);
-		dump_end_specalization(out);
-	}
-
-private:
-	void dump_begin_specalization(clang::raw_ostream& out) const 
-	{
-		std::string name = get_qualified_name();
-		out << "// @class reflect<" << name << ">\n";
-		out << "template <>\nclass reflect<" << name << ">\n{\n";
-		out << "public:\n\ttypedef " << name << " Type;\n";
-		out << "\ttypedef std::set<std::string> names;\n\n";
-		out << "public:\n";
-	}
-
-	void dump_end_specalization(clang::raw_ostream& out) const 
-	{
-		out << "\n}; // class reflect<" << get_name() << ">\n\n\n";
-	}
-
-	void dump_get_name(clang::raw_ostream& out) const 
-	{
-		out << "\tstatic std::string get_name()\n\t{\n";
-		out << "\t\treturn \"" << get_name() << "\";\t\n\t}\n\n";
-	}
-
-	void dump_get_qualified_name(clang::raw_ostream& out) const
-	{
-		out << "\tstatic std::string get_qualified_name()\n\t{\n";
-		out << "\t\treturn \"" << get_qualified_name() << "\";\t\n\t}\n\n";
-	}
-
-	void dump_get_num_bases(clang::raw_ostream& out) const 
-	{
-		out << "\tstatic int get_num_bases()\n\t{\n";
-		out << "\t\treturn " << get_num_bases() << ";\n\t}\n\n";
-	}
-
-	void dump_get_num_virtual_bases(clang::raw_ostream& out) const 
-	{
-		out << "\tstatic int get_num_virtual_bases()\n\t{\n";
-		out << "\t\treturn " << get_num_virtual_bases() << ";\n\t}\n\n";
-	}
-
-	void dump_get_methods(clang::raw_ostream& out) const
-	{
-		out << "\tstatic void get_methods(names& ns)\n\t{\n";
-		method_info::method_names names;
-		m_methods.get_methods(names);
-		for (auto i : names ) {
-			out << "\t\tns.insert(\"" << i << "\");\n";
-		}
-		out << "\t}\n\n";
-	}
-
-	void dump_is_abstract(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool is_abstract()\n\t{\n";
-		out << "\t\treturn " << (is_abstract() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_is_polymorphic(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool is_polymorphic()\n\t{\n";
-		out << "\t\treturn " << (is_polymorphic() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_has_default_constructor(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool has_default_constructor()\n\t{\n";
-		out << "\t\treturn "<< (has_default_constructor() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_create(clang::raw_ostream& out) const 
-	{
-		out << "\ttemplate<typename ...Args>\n";
-		out << "\tstatic Type create(const Args&...args)\n\t{\n";
-		out << "\t\treturn Type(std::forward<const Args&>(args)...);\n\t}\n\n";
-	}
-
-	void dump_get_base_names(clang::raw_ostream& out) const 
-	{
-		out << "\tstatic void get_base_names(names& ns)\n\t{\n";
-		source_class::base_class_iterator b = m_source_class->bases_begin();
-		source_class::base_class_iterator e = m_source_class->bases_end();
-		if (b == e) {
-			out << "\t\t/// Has not base\n";
-		}
-		for (; b != e; ++b) {
-			out << "\t\tns.insert(\"" << b->getType().getAsString() << "\");\n";
-		}
-		out << "\t}\n\n";
-	}
-
-	void dump_has_any_dependent_bases(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool has_any_dependent_bases()\n\t{\n";
-		out << "\t\treturn " << (has_any_dependent_bases() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_has_friends(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool has_friends()\n\t{\n";
-		out << "\t\treturn " << (has_friends() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_has_user_declared_constructor(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool has_user_declared_constructor()\n\t{\n";
-		out << "\t\treturn " << (has_user_declared_constructor() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_has_user_declared_copy_assignment(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool has_user_declared_copy_assignment()\n\t{\n";
-		out << "\t\treturn " << (has_user_declared_copy_assignment() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_has_user_declared_destructor(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool has_user_declared_destructor()\n\t{\n";
-		out << "\t\treturn " << (has_user_declared_destructor() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_has_user_provided_default_constructor(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool has_user_provided_default_constructor()\n\t{\n";
-		out << "\t\treturn " << (has_user_provided_default_constructor() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_is_aggregate(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool is_aggregate()\n\t{\n";
-		out << "\t\treturn " << (is_aggregate() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_is_derived_from(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool is_derived_from(const std::string& base_name)\n\t{\n";
-		out << "\t\tnames ns;\n";
-		out << "\t\tget_base_names(ns);\n";
-		out << "\t\treturn ns.find(\"class \" + base_name) != ns.end();\n\t}\n\n";
-	}
-
-	void dump_is_template_decl(clang::raw_ostream& out) const
-	{
-		out << "\tstatic bool is_template_decl()\n\t{\n";
-		out << "\t\treturn " << (is_template_decl() ? "true" : "false") << ";\n\t}\n\n";
-	}
-
-	void dump_invokes(clang::raw_ostream& out) const
-	{
-		if (!is_abstract()) {
-			m_methods.dump(out);
-		}
-	}
-	
-private:
-	source_class* m_source_class;
-	invoke_output m_methods;
-}; // class reflected_class
-
-#endif // REFLECTED_CLASS_HPP
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef REFLECTED_CLASS_HPP
+#define REFLECTED_CLASS_HPP
+
+#include "debug.hpp"
+#include "member_output.hpp"
+#include "model.hpp"
+#include "profile.hpp"
+#include "type_info_output.hpp"
+#include "utils.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <sstream>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// @class method_info
+// @brief Signature shared by group of methods, which one invoke serves.
+class method_info
+{
+public:
+	typedef reflector::model::method method;
+	typedef std::set<std::string> method_names;
+	typedef std::vector<std::string> type_names;
+public:
+	explicit method_info(const method& m)
+		: m_return_type(m.return_type)
+		, m_param_type_names(m.param_types)
+		, m_is_const(m.is_const)
+	{
+		extract_lists();
+	}
+
+	//@brief Gets key which is equal for methods of the same signature.
+	static void get_key(const method& m, std::string& key)
+	{
+		key.clear();
+		key += m.is_const ? '1' : '0';
+		key += m.return_type;
+		for (auto& t : m.param_types) {
+			key += '\0';
+			key += t;
+		}
+	}
+
+	//@brief Gets key which is equal for invokes of the same parameters,
+	//       return type does not take part in overload resolution.
+	std::string get_invoke_key() const
+	{
+		std::string key(1, m_is_const ? '1' : '0');
+		for (auto& t : m_param_type_names) {
+			key += '\0';
+			key += t;
+		}
+		return key;
+	}
+
+	static const std::string& get_type_def()
+	{
+		static const std::string def = "FuncPtrToClassMethod";
+		return def;
+	}
+
+	const std::string& get_signture() const
+	{
+		return m_signature;
+	}
+
+	const std::string& get_param_type_list() const
+	{
+		return m_param_types;
+	}
+
+	const type_names& get_param_types() const
+	{
+		return m_param_type_names;
+	}
+
+	const std::string& get_forward_arguments() const
+	{
+		return m_forward_arguments;
+	}
+
+	const std::string& get_return_type() const
+	{
+		return m_return_type;
+	}
+
+	unsigned get_params_count() const
+	{
+		return m_param_type_names.size();
+	}
+
+	bool is_const() const
+	{
+		return m_is_const;
+	}
+
+	bool has_param() const
+	{
+		return 0 < get_params_count();
+	}
+
+	bool non_void_return_type() const
+	{
+		return m_return_type != "void";
+	}
+private:
+	//@brief Builds signature, parameter list and forward arguments from
+	//       parameter types in one pass.
+	void extract_lists()
+	{
+		m_signature = get_return_type();
+		m_signature += " (Type::*";
+		m_signature += get_type_def();
+		m_signature += ")(";
+		for (std::size_t i = 0; i < m_param_type_names.size(); ++i) {
+			const std::string& t = m_param_type_names[i];
+			const std::string p = "p" + std::to_string(i + 1);
+			const char* separator = 0 == i ? "" : ", ";
+			m_signature.append(separator).append(t);
+			m_param_types.append(separator).append(t).append(" ").append(p);
+			m_forward_arguments.append(separator).append("std::forward<").append(t).append(">(").append(p).append(")");
+		}
+		m_signature += is_const() ? ") const" : ")";
+	}
+
+	//@TODO implement
+	//void keep_code_stile(std::string& str, unsigned count) const
+	//{
+	//	if (0 == count) {
+	//		return;
+	//	}
+	//	std::string::size_type pos = count;
+	//	std::string tab = "\n\t\t\t\t";
+	//	while (str.size() > pos && (pos = str.find(',', pos)) != std::string::npos) {
+	//		str.insert(pos + 1, tab);
+	//		pos += count - (tab.size() / 2 - 3) * (count / 10);
+	//		tab += "\t";
+	//	}
+	//}
+
+private:
+	std::string m_return_type;
+	type_names m_param_type_names;
+	bool m_is_const;
+	std::string m_param_types;
+	std::string m_forward_arguments;
+	std::string m_signature;
+}; // class method_info
+
+//@class invoke_output
+//@brief Groups methods by signature, one invoke per group. Signatures are
+//       interned: each gets id on first occurrence, later methods only
+//       look up their key, groups keep order of first occurrence.
+class invoke_output
+{
+private:
+	typedef method_info::method_names method_names;
+	typedef std::pair<method_info, method_names> group;
+	typedef std::vector<group> groups;
+	typedef std::unordered_map<std::string, std::size_t> signature_ids;
+public:
+	invoke_output()
+	{
+	}
+
+	explicit invoke_output(const reflector::model::record::methods_type& ms)
+	{
+		signature_ids ids;
+		std::string key;
+		for (auto& m : ms) {
+			method_info::get_key(m, key);
+			std::pair<signature_ids::iterator, bool> i = ids.insert(std::make_pair(key, m_groups.size()));
+			if (i.second) {
+				m_groups.push_back(group(method_info(m), method_names()));
+			}
+			m_groups[i.first->second].second.insert(m.name);
+		}
+	}
+public:
+
+	bool has_methods() const
+	{
+		return !m_groups.empty();
+	}
+
+	//@brief Moves groups which all outputs have, with the same signature
+	//       and names, into common. Whole groups move, so invoke of one
+	//       signature stays in one place.
+	// @note: Invoke of derived reflect hides invoke of common with the same
+	//        parameters even through using declaration, so groups of one
+	//        invoke key move only all together, when every output has all
+	//        its groups of that key in common.
+	static void extract_common(const std::vector<invoke_output*>& os, invoke_output& common)
+	{
+		ASSERT(!os.empty());
+		for (auto& g : os.front()->m_groups) {
+			bool shared = true;
+			for (std::size_t i = 1; shared && i < os.size(); ++i) {
+				shared = os[i]->m_groups.end() != os[i]->find(g);
+			}
+			if (shared) {
+				common.m_groups.push_back(g);
+			}
+		}
+		std::set<std::string> kept;
+		for (auto o : os) {
+			for (auto& g : o->m_groups) {
+				if (common.m_groups.end() == common.find(g)) {
+					kept.insert(g.first.get_invoke_key());
+				}
+			}
+		}
+		common.m_groups.erase(std::remove_if(common.m_groups.begin(), common.m_groups.end(),
+			[&kept](const group& g)
+			{
+				return 0 != kept.count(g.first.get_invoke_key());
+			}
+		), common.m_groups.end());
+		for (auto o : os) {
+			for (auto& g : common.m_groups) {
+				o->m_groups.erase(o->find(g));
+			}
+		}
+	}
+
+	void get_methods(method_names& ns) const
+	{
+		for (auto& i : m_groups) {
+			ns.insert(i.second.begin(), i.second.end());
+		}
+	}
+
+	//@brief Calls f(info, name) for each reflected method.
+	template <typename Functor>
+	void for_each_method(Functor f) const
+	{
+		for (auto& i : m_groups) {
+			for (auto& n : i.second) {
+				f(i.first, n);
+			}
+		}
+	}
+
+	//@param qualified calls methods by qualified name, for final class
+	void dump(const member_output& m, const std::string& class_name, const reflector::profile& p,
+		  bool qualified) const
+	{
+		for (auto& i : m_groups) {
+			 dump(m, i.first, i.second, class_name, p, qualified);
+		}
+	}
+
+private:
+	groups::iterator find(const group& g)
+	{
+		for (groups::iterator i = m_groups.begin(); i != m_groups.end(); ++i) {
+			if (i->first.get_signture() == g.first.get_signture() && i->second == g.second) {
+				return i;
+			}
+		}
+		return m_groups.end();
+	}
+
+	void dump(const member_output& m, const method_info& info, const method_names& names,
+		  const std::string& class_name, const reflector::profile& p, bool qualified) const
+	{
+		ASSERT(!names.empty());
+		std::string const_qualifier = info.is_const() ? "const " : "";
+		std::string signature = "invoke(" + const_qualifier + "Type & o, const char * n";
+		if (info.has_param()) {
+			signature += ", " + info.get_param_type_list();
+		}
+		signature += ")";
+		std::string body;
+		llvm::raw_string_ostream out(body);
+		out << "\t\tstatic constexpr const char* const names[] = {";
+		for (auto i : names) {
+			out << "\n\t\t\t\"" << i << "\",";
+		}
+		out << "\n\t\t};\n";
+		out << "#ifdef REFLECT_PROFILE\n";
+		out << "\t\tstatic reflect_profile::counter counter(\"" << class_name << "\", names, " << names.size() << ");\n";
+		out << "\t\tcounter.hit(n);\n";
+		out << "#endif // REFLECT_PROFILE\n";
+		dump_hot_path(out, info, names, class_name, p, qualified);
+		if (qualified) {
+			dump_qualified_calls(out, info, names);
+			m.dump(info.get_return_type(), signature, out.str());
+			return;
+		}
+		out << "\t\ttypedef " << info.get_signture() << ";\n";
+		out << "\t\tstatic constexpr " << method_info::get_type_def() << " methods[] = {";
+		for (auto i : names) {
+			out << "\n\t\t\t&Type::" << i << ",";
+		}
+		out << "\n\t\t};\n";
+		out << "\t\t";
+		if (info.non_void_return_type()) {
+			out << "return ";
+		}
+		out << "(o.*methods[reflect_dispatcher::find(names, " << names.size() << ", n)])("
+		    << info.get_forward_arguments() <<  ");\n";
+		m.dump(info.get_return_type(), signature, out.str());
+	}
+
+	//@brief Dispatches by index of name to calls which do not go through
+	//       virtual table and can be inlined, unlike method pointers.
+	void dump_qualified_calls(clang::raw_ostream& out, const method_info& info, const method_names& names) const
+	{
+		out << "\t\tswitch (reflect_dispatcher::find(names, " << names.size() << ", n)) {\n";
+		std::size_t index = 0;
+		for (auto i : names) {
+			// @note: find throws for unknown name, the last case is default.
+			if (++index == names.size()) {
+				out << "\t\tdefault:\n\t\t\t";
+			} else {
+				out << "\t\tcase " << index - 1 << ":\n\t\t\t";
+			}
+			if (info.non_void_return_type()) {
+				out << "return ";
+			}
+			out << "o.Type::" << i << "(" << info.get_forward_arguments() << ");\n";
+			if (!info.non_void_return_type()) {
+				out << "\t\t\treturn;\n";
+			}
+		}
+		out << "\t\t}\n";
+	}
+
+	void dump_hot_path(clang::raw_ostream& out, const method_info& info, const method_names& names,
+			   const std::string& class_name, const reflector::profile& p, bool qualified) const
+	{
+		reflector::profile::hits hot;
+		p.get_hot(class_name, names, hot);
+		if (hot.empty()) {
+			return;
+		}
+		out << "\t\t// @note: Profile guided fast path\n";
+		for (auto i : hot) {
+			out << "\t\tif (0 == std::strcmp(n, \"" << i.second << "\")) {\n\t\t\t";
+			if (info.non_void_return_type()) {
+				out << "return ";
+			}
+			out << (qualified ? "o.Type::" : "o.") << i.second << "(" << info.get_forward_arguments() << ");\n";
+			if (!info.non_void_return_type()) {
+				out << "\t\t\treturn;\n";
+			}
+			out << "\t\t}\n";
+		}
+	}
+
+private:
+	groups m_groups;
+}; // class invoke_output
+
+//@class reflected_template
+//@brief Partial specialization of reflect_template for all instantiations
+//       of one class template, with invokes which reflected ones have in
+//       common. Their reflect specializations derive from it.
+class reflected_template
+{
+public:
+	typedef std::shared_ptr<const reflected_template> ptr;
+public:
+	//@param name qualified name of class template
+	reflected_template(const std::string& name, const std::string& parameters,
+			   const std::string& arguments, const invoke_output& methods, bool qualified)
+		: m_name(name)
+		, m_parameters(parameters)
+		, m_arguments(arguments)
+		, m_methods(methods)
+		, m_qualified(qualified)
+	{
+	}
+
+	const invoke_output& get_methods() const
+	{
+		return m_methods;
+	}
+
+	//@brief Gets base class of reflect of instantiation.
+	//@param instantiation qualified name with arguments
+	static std::string get_base_name(const std::string& instantiation)
+	{
+		return "reflect_template<" + instantiation + " >";
+	}
+
+	//@brief Dumps body, it is always defined in header. Profile counts
+	//       calls under name of template.
+	void dump(clang::raw_ostream& out, const reflector::profile& p) const
+	{
+		const std::string type = m_name + "<" + m_arguments + ">";
+		out << "// @class " << get_base_name(type) << "\n";
+		out << "template <" << m_parameters << ">\nclass " << get_base_name(type) << "\n{\n";
+		out << "public:\n\ttypedef " << type << " Type;\n\n";
+		out << "public:\n";
+		m_methods.dump(member_output(out, member_output::inline_part, type), m_name, p, m_qualified);
+		out << "}; // class reflect_template<" << m_name << ">\n\n\n";
+	}
+
+private:
+	std::string m_name;
+	std::string m_parameters;
+	std::string m_arguments;
+	invoke_output m_methods;
+	bool m_qualified;
+}; // class reflected_template
+
+//@class reflected_class
+class reflected_class
+{
+private:
+	typedef reflector::model::record source_class;
+public:
+	typedef std::shared_ptr<reflected_class> ptr;
+	typedef std::list<ptr> reflected_collection;
+public:
+	explicit reflected_class(const source_class& r)
+		: m_source_class(r)
+		, m_methods(r.methods)
+	{
+	}
+
+	//@brief Gets reflected fields, without fields left out by selection.
+	source_class::fields_type get_fields() const
+	{
+		source_class::fields_type fs;
+		for (auto& f : m_source_class.fields) {
+			if (f.is_selected) {
+				fs.push_back(f);
+			}
+		}
+		return fs;
+	}
+
+	const source_class::bases_type& get_bases() const
+	{
+		return m_source_class.bases;
+	}
+
+	const invoke_output& get_methods() const
+	{
+		return m_methods;
+	}
+
+	//@brief Gets body shared with other instantiations, or null.
+	const reflected_template::ptr& get_template() const
+	{
+		return m_template;
+	}
+
+	//@brief Gives instantiations of each class template, which have
+	//       invokes in common, one reflect_template body with them.
+	//       Classes must be dumped together, in one output.
+	static void share_templates(const std::vector<ptr>& classes)
+	{
+		typedef std::map<std::string, std::vector<reflected_class*> > instantiations;
+		instantiations is;
+		for (auto& c : classes) {
+			const source_class& r = c->m_source_class;
+			if (!r.template_parameters.empty() && !c->is_abstract() && 0 == c->m_template) {
+				is[r.template_name].push_back(c.get());
+			}
+		}
+		for (auto& i : is) {
+			if (i.second.size() < 2) {
+				continue;
+			}
+			std::vector<invoke_output*> ms;
+			for (auto c : i.second) {
+				ms.push_back(&c->m_methods);
+			}
+			invoke_output common;
+			invoke_output::extract_common(ms, common);
+			if (!common.has_methods()) {
+				continue;
+			}
+			// @note: Instantiations of final partial specialization share
+			//        body with others, calls are qualified only when all
+			//        of them are final.
+			bool qualified = true;
+			for (auto c : i.second) {
+				qualified = qualified && c->is_final();
+			}
+			const source_class& r = i.second.front()->m_source_class;
+			const reflected_template::ptr t = std::make_shared<reflected_template>(
+				r.template_name, r.template_parameters, r.template_arguments, common, qualified);
+			for (auto c : i.second) {
+				c->m_template = t;
+			}
+		}
+	}
+
+	//@brief Gets sizeof of class.
+	unsigned get_size() const
+	{
+		return m_source_class.size;
+	}
+
+	//@brief Gets alignof of class.
+	unsigned get_alignment() const
+	{
+		return m_source_class.alignment;
+	}
+
+	//@brief Gets class key: "class", "struct" or "union".
+	const std::string& get_kind_name() const
+	{
+		return m_source_class.kind;
+	}
+
+	const std::string& get_qualified_name() const
+	{
+		return m_source_class.qualified_name;
+	}
+
+	const std::string& get_name() const
+	{
+		return m_source_class.name;
+	}
+
+	//@brief Gets name returned by std::type_info::name.
+	const std::string& get_type_name() const
+	{
+		return m_source_class.type_name;
+	}
+
+	int get_num_bases() const
+	{
+		return m_source_class.bases.size();
+	}
+
+	bool has_any_dependent_bases() const
+	{
+		return m_source_class.has(reflector::model::trait_any_dependent_bases);
+	}
+
+	bool has_friends() const
+	{
+		return m_source_class.has(reflector::model::trait_friends);
+	}
+
+	bool has_user_declared_constructor() const
+	{
+		return m_source_class.has(reflector::model::trait_user_declared_constructor);
+	}
+
+	bool has_user_declared_copy_assignment() const
+	{
+		return m_source_class.has(reflector::model::trait_user_declared_copy_assignment);
+	}
+
+	bool has_user_declared_destructor() const
+	{
+		return m_source_class.has(reflector::model::trait_user_declared_destructor);
+	}
+
+	bool has_user_provided_default_constructor() const
+	{
+		return m_source_class.has(reflector::model::trait_user_provided_default_constructor);
+	}
+
+	bool is_aggregate() const
+	{
+		return m_source_class.has(reflector::model::trait_aggregate);
+	}
+
+	//@param base_name qualified name of direct base
+	bool is_derived_from(const std::string& base_name) const
+	{
+		method_info::method_names names;
+		get_base_names(names);
+		return names.find(base_name) != names.end();
+	}
+
+	bool is_template_decl() const
+	{
+		return m_source_class.has(reflector::model::trait_template_decl);
+	}
+
+	//@brief Checks that class is specialization of template, it can not
+	//       be declared by name.
+	bool is_template_specialization() const
+	{
+		return m_source_class.has(reflector::model::trait_template_specialization);
+	}
+
+	bool is_polymorphic() const
+	{
+		return m_source_class.has(reflector::model::trait_polymorphic);
+	}
+
+	int get_num_virtual_bases() const
+	{
+		return m_source_class.num_virtual_bases;
+	}
+
+	bool is_final() const
+	{
+		return m_source_class.has(reflector::model::trait_final);
+	}
+
+	bool is_abstract() const
+	{
+		return m_source_class.has(reflector::model::trait_abstract);
+	}
+
+	bool has_default_constructor() const
+	{
+		return m_source_class.has(reflector::model::trait_default_constructor);
+	}
+
+	bool is_union() const
+	{
+		return m_source_class.has(reflector::model::trait_union);
+	}
+
+	bool is_empty() const
+	{
+		return m_source_class.has(reflector::model::trait_empty);
+	}
+
+	bool is_trivial() const
+	{
+		return m_source_class.has(reflector::model::trait_trivial);
+	}
+
+	bool is_trivially_copyable() const
+	{
+		return m_source_class.has(reflector::model::trait_trivially_copyable);
+	}
+
+	bool is_standard_layout() const
+	{
+		return m_source_class.has(reflector::model::trait_standard_layout);
+	}
+
+	bool is_pod() const
+	{
+		return m_source_class.has(reflector::model::trait_pod);
+	}
+
+	//@brief Checks that equal objects have equal bytes,
+	//       i.e. object can be compared with memcmp.
+	bool has_unique_representation() const
+	{
+		return m_source_class.has(reflector::model::trait_unique_representation);
+	}
+
+	void get_base_names(method_info::method_names& names) const
+	{
+		for (auto& b : m_source_class.bases) {
+			names.insert(b.name);
+		}
+	}
+ 
+	//@brief Dumps specialization.
+	//@param part inline_part defines all members in class, declaration_part
+	//       only declares members holding strings and tables and
+	//       definition_part defines them out of class, for source file.
+	void dump(clang::raw_ostream& out, const reflector::profile& p,
+		  member_output::part part = member_output::inline_part) const
+	{
+		type_info_output info(get_kind_name(), get_name(), get_qualified_name(), m_source_class.type_name);
+		const member_output m(out, part, get_qualified_name());
+		if (member_output::declaration_part != part) {
+			info.dump_entry(out);
+		}
+		if (member_output::definition_part == part) {
+			dump_members(m, info, p);
+			return;
+		}
+		dump_begin_specalization(out);
+		dump_members(m, info, p);
+		dump_create(out);
+		dump_get_num_bases(out);
+		dump_get_num_virtual_bases(out);
+		dump_has_default_constructor(out);
+		dump_has_any_dependent_bases(out);
+		dump_has_friends(out);
+		dump_has_user_declared_constructor(out);
+		dump_has_user_declared_copy_assignment(out);
+		dump_has_user_declared_destructor(out);
+		dump_has_user_provided_default_constructor(out);
+		dump_is_aggregate(out);
+		dump_is_template_decl(out);
+		dump_is_abstract(out);
+		dump_is_polymorphic(out);
+		dump_traits(out);
+		dump_bulk_operations(out);
+		dump_end_specalization(out);
+	}
+
+private:
+	//@brief Dumps members which may be defined out of class.
+	void dump_members(const member_output& m, const type_info_output& info, const reflector::profile& p) const
+	{
+		info.dump_get_type_info(m);
+		dump_get_name(m);
+		dump_get_qualified_name(m);
+		dump_get_base_names(m);
+		dump_get_methods(m);
+		dump_is_derived_from(m);
+		dump_invokes(m, p);
+	}
+
+	void dump_begin_specalization(clang::raw_ostream& out) const 
+	{
+		std::string name = get_qualified_name();
+		out << "// @class reflect<" << name << ">\n";
+		out << "template <>\nclass reflect<" << name << ">";
+		if (0 != m_template) {
+			out << " : public " << reflected_template::get_base_name(name);
+		}
+		out << "\n{\n";
+		out << "public:\n\ttypedef " << name << " Type;\n";
+		out << "\ttypedef std::set<std::string> names;\n\n";
+		out << "public:\n";
+		if (0 != m_template) {
+			out << "\tusing " << reflected_template::get_base_name(name) << "::invoke;\n\n";
+		}
+	}
+
+	void dump_end_specalization(clang::raw_ostream& out) const 
+	{
+		out << "\n}; // class reflect<" << get_name() << ">\n\n\n";
+	}
+
+	void dump_get_name(const member_output& m) const 
+	{
+		m.dump("std::string", "get_name()", "\t\treturn \"" + get_name() + "\";\t\n");
+	}
+
+	void dump_get_qualified_name(const member_output& m) const
+	{
+		m.dump("std::string", "get_qualified_name()", "\t\treturn \"" + get_qualified_name() + "\";\t\n");
+	}
+
+	void dump_get_num_bases(clang::raw_ostream& out) const 
+	{
+		out << "\tstatic int get_num_bases()\n\t{\n";
+		out << "\t\treturn " << get_num_bases() << ";\n\t}\n\n";
+	}
+
+	void dump_get_num_virtual_bases(clang::raw_ostream& out) const 
+	{
+		out << "\tstatic int get_num_virtual_bases()\n\t{\n";
+		out << "\t\treturn " << get_num_virtual_bases() << ";\n\t}\n\n";
+	}
+
+	void dump_get_methods(const member_output& m) const
+	{
+		std::string body;
+		method_info::method_names names;
+		m_methods.get_methods(names);
+		if (0 != m_template) {
+			m_template->get_methods().get_methods(names);
+		}
+		for (auto i : names ) {
+			body += "\t\tns.insert(\"" + i + "\");\n";
+		}
+		m.dump("void", "get_methods(names& ns)", body);
+	}
+
+	void dump_is_abstract(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool is_abstract()\n\t{\n";
+		out << "\t\treturn " << (is_abstract() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_is_polymorphic(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool is_polymorphic()\n\t{\n";
+		out << "\t\treturn " << (is_polymorphic() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_has_default_constructor(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool has_default_constructor()\n\t{\n";
+		out << "\t\treturn "<< (has_default_constructor() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_create(clang::raw_ostream& out) const 
+	{
+		out << "\ttemplate<typename ...Args>\n";
+		out << "\tstatic Type create(const Args&...args)\n\t{\n";
+		out << "\t\treturn Type(std::forward<const Args&>(args)...);\n\t}\n\n";
+	}
+
+	void dump_get_base_names(const member_output& m) const 
+	{
+		std::string body;
+		if (m_source_class.bases.empty()) {
+			body += "\t\t/// Has not base\n";
+		}
+		for (auto& b : m_source_class.bases) {
+			body += "\t\tns.insert(\"" + b.name + "\");\n";
+		}
+		m.dump("void", "get_base_names(names& ns)", body);
+	}
+
+	void dump_has_any_dependent_bases(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool has_any_dependent_bases()\n\t{\n";
+		out << "\t\treturn " << (has_any_dependent_bases() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_has_friends(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool has_friends()\n\t{\n";
+		out << "\t\treturn " << (has_friends() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_has_user_declared_constructor(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool has_user_declared_constructor()\n\t{\n";
+		out << "\t\treturn " << (has_user_declared_constructor() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_has_user_declared_copy_assignment(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool has_user_declared_copy_assignment()\n\t{\n";
+		out << "\t\treturn " << (has_user_declared_copy_assignment() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_has_user_declared_destructor(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool has_user_declared_destructor()\n\t{\n";
+		out << "\t\treturn " << (has_user_declared_destructor() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_has_user_provided_default_constructor(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool has_user_provided_default_constructor()\n\t{\n";
+		out << "\t\treturn " << (has_user_provided_default_constructor() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_is_aggregate(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool is_aggregate()\n\t{\n";
+		out << "\t\treturn " << (is_aggregate() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_is_derived_from(const member_output& m) const
+	{
+		std::string body = "\t\tnames ns;\n";
+		body += "\t\tget_base_names(ns);\n";
+		body += "\t\treturn ns.find(base_name) != ns.end();\n";
+		m.dump("bool", "is_derived_from(const std::string& base_name)", body);
+	}
+
+	void dump_is_template_decl(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool is_template_decl()\n\t{\n";
+		out << "\t\treturn " << (is_template_decl() ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_constexpr_bool(clang::raw_ostream& out, const char* name, bool value) const
+	{
+		out << "\tstatic constexpr bool " << name << "()\n\t{\n";
+		out << "\t\treturn " << (value ? "true" : "false") << ";\n\t}\n\n";
+	}
+
+	void dump_traits(clang::raw_ostream& out) const
+	{
+		dump_constexpr_bool(out, "is_union", is_union());
+		dump_constexpr_bool(out, "is_empty", is_empty());
+		dump_constexpr_bool(out, "is_trivial", is_trivial());
+		dump_constexpr_bool(out, "is_trivially_copyable", is_trivially_copyable());
+		dump_constexpr_bool(out, "is_standard_layout", is_standard_layout());
+		dump_constexpr_bool(out, "is_pod", is_pod());
+		dump_constexpr_bool(out, "has_unique_representation", has_unique_representation());
+	}
+
+	//@brief Dumps copy, compare and serialize through memory operations.
+	//       Types which are not trivially copyable have none of them.
+	void dump_bulk_operations(clang::raw_ostream& out) const
+	{
+		if (!is_trivially_copyable()) {
+			return;
+		}
+		out << "\tstatic void copy(Type& to, const Type& from)\n\t{\n";
+		out << "\t\tstd::memcpy(&to, &from, sizeof(Type));\n\t}\n\n";
+		if (has_unique_representation()) {
+			out << "\tstatic bool equal(const Type& o1, const Type& o2)\n\t{\n";
+			out << "\t\treturn 0 == std::memcmp(&o1, &o2, sizeof(Type));\n\t}\n\n";
+		}
+		out << "\tstatic constexpr std::size_t get_serialized_size()\n\t{\n";
+		out << "\t\treturn sizeof(Type);\n\t}\n\n";
+		out << "\tstatic void serialize(const Type& o, void* buffer)\n\t{\n";
+		out << "\t\tstd::memcpy(buffer, &o, sizeof(Type));\n\t}\n\n";
+		out << "\tstatic void deserialize(const void* buffer, Type& o)\n\t{\n";
+		out << "\t\tstd::memcpy(&o, buffer, sizeof(Type));\n\t}\n\n";
+	}
+
+	void dump_invokes(const member_output& m, const reflector::profile& p) const
+	{
+		if (!is_abstract()) {
+			m_methods.dump(m, get_qualified_name(), p, is_final());
+		}
+	}
+	
+private:
+	source_class m_source_class;
+	invoke_output m_methods;
+	reflected_template::ptr m_template;
+}; // class reflected_class
+
+#endif // REFLECTED_CLASS_HPP
@@ -0,0 +1,327 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef REFLECTED_ENUM_HPP
+#define REFLECTED_ENUM_HPP
+
+#include "debug.hpp"
+#include "model.hpp"
+#include "type_info_output.hpp"
+#include "utils.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <string>
+#include <vector>
+
+//@class perfect_hash
+//@brief Finds a collision free FNV-1a seed for fixed set of names.
+//       The generated code evaluates the same hash in constexpr function.
+class perfect_hash
+{
+public:
+	typedef std::vector<std::string> names;
+	typedef std::vector<unsigned> slots;
+public:
+	explicit perfect_hash(const names& ns)
+		: m_seed(basis())
+		, m_mask(1)
+	{
+		while (m_mask + 1 < 2 * ns.size()) {
+			m_mask = (m_mask << 1) | 1;
+		}
+		while (!try_seed(ns)) {
+			if (++m_seed - basis() == max_tries()) {
+				m_seed = basis();
+				m_mask = (m_mask << 1) | 1;
+			}
+		}
+	}
+
+	static std::uint32_t prime()
+	{
+		return 16777619u;
+	}
+
+	std::uint32_t get_seed() const
+	{
+		return m_seed;
+	}
+
+	std::uint32_t get_mask() const
+	{
+		return m_mask;
+	}
+
+	//@brief Gets table of slots, each slot is index of name plus one or zero.
+	const slots& get_slots() const
+	{
+		return m_slots;
+	}
+
+private:
+	static std::uint32_t basis()
+	{
+		return 2166136261u;
+	}
+
+	static std::uint32_t max_tries()
+	{
+		return 4096;
+	}
+
+	bool try_seed(const names& ns)
+	{
+		m_slots.assign(m_mask + 1, 0);
+		for (unsigned i = 0; i < ns.size(); ++i) {
+			unsigned& slot = m_slots[utils::fnv1a(ns[i], m_seed) & m_mask];
+			if (0 != slot) {
+				return false;
+			}
+			slot = i + 1;
+		}
+		return true;
+	}
+
+private:
+	std::uint32_t m_seed;
+	std::uint32_t m_mask;
+	slots m_slots;
+}; // class perfect_hash
+
+//@class reflected_enum
+class reflected_enum
+{
+private:
+	typedef reflector::model::enumeration source_enum;
+	typedef source_enum::enumerator enumerator;
+	typedef source_enum::enumerators enumerators;
+public:
+	typedef std::shared_ptr<reflected_enum> ptr;
+	typedef std::list<ptr> reflected_collection;
+public:
+	explicit reflected_enum(const source_enum& e)
+		: m_source_enum(e)
+		, m_declared(e.values)
+	{
+		ASSERT(!m_declared.empty());
+		m_values = m_declared;
+		std::stable_sort(m_values.begin(), m_values.end(),
+			[](const enumerator& e1, const enumerator& e2)
+			{
+				return e1.first < e2.first;
+			}
+		);
+		m_values.erase(std::unique(m_values.begin(), m_values.end(),
+			[](const enumerator& e1, const enumerator& e2)
+			{
+				return e1.first == e2.first;
+			}), m_values.end());
+	}
+
+	const std::string& get_qualified_name() const
+	{
+		return m_source_enum.qualified_name;
+	}
+
+	const std::string& get_name() const
+	{
+		return m_source_enum.name;
+	}
+
+	//@brief Checks that distinct values have no holes.
+	bool is_contiguous() const
+	{
+		return m_values.back().first - m_values.front().first + 1 == static_cast<long long>(m_values.size());
+	}
+
+	void dump(clang::raw_ostream& out) const
+	{
+		perfect_hash::names names;
+		for (auto e : m_declared) {
+			names.push_back(e.second);
+		}
+		perfect_hash h(names);
+		type_info_output info("enum", get_name(), get_qualified_name(), m_source_enum.type_name);
+		info.dump_entry(out);
+		dump_begin_specalization(out);
+		info.dump_get_type_info(member_output(out, member_output::inline_part, get_qualified_name()));
+		dump_get_count(out);
+		dump_get_name(out);
+		dump_get_qualified_name(out);
+		dump_get_value(out);
+		dump_is_valid(out);
+		dump_to_string(out);
+		dump_find(out, h);
+		dump_from_string(out);
+		dump_private(out, h);
+		dump_end_specalization(out);
+		dump_table_definitions(out);
+	}
+
+private:
+	void dump_begin_specalization(clang::raw_ostream& out) const
+	{
+		std::string name = get_qualified_name();
+		out << "// @class reflect<" << name << ">\n";
+		out << "template <>\nclass reflect<" << name << ">\n{\n";
+		out << "public:\n\ttypedef " << name << " Type;\n";
+		out << "\ttypedef std::underlying_type<Type>::type underlying_type;\n\n";
+		out << "public:\n";
+	}
+
+	void dump_end_specalization(clang::raw_ostream& out) const
+	{
+		out << "}; // class reflect<" << get_name() << ">\n\n";
+	}
+
+	void dump_get_count(clang::raw_ostream& out) const
+	{
+		out << "\t// @brief Gets count of distinct values\n";
+		out << "\tstatic constexpr std::size_t get_count()\n\t{\n";
+		out << "\t\treturn " << m_values.size() << ";\n\t}\n\n";
+	}
+
+	void dump_get_name(clang::raw_ostream& out) const
+	{
+		out << "\tstatic constexpr const char* get_name()\n\t{\n";
+		out << "\t\treturn \"" << get_name() << "\";\n\t}\n\n";
+	}
+
+	void dump_get_qualified_name(clang::raw_ostream& out) const
+	{
+		out << "\tstatic constexpr const char* get_qualified_name()\n\t{\n";
+		out << "\t\treturn \"" << get_qualified_name() << "\";\n\t}\n\n";
+	}
+
+	void dump_get_value(clang::raw_ostream& out) const
+	{
+		out << "\t// @brief Gets i-th distinct value in ascending order\n";
+		out << "\tstatic constexpr Type get_value(std::size_t i)\n\t{\n";
+		out << "\t\treturn table<>::values[i];\n\t}\n\n";
+	}
+
+	void dump_is_valid(clang::raw_ostream& out) const
+	{
+		out << "\tstatic constexpr bool is_valid(Type v)\n\t{\n";
+		if (is_contiguous()) {
+			out << "\t\treturn to_underlying(v) >= to_underlying(Type::" << m_values.front().second << ") &&\n";
+			out << "\t\t       to_underlying(v) <= to_underlying(Type::" << m_values.back().second << ");\n\t}\n\n";
+		} else {
+			out << "\t\treturn index_of(to_underlying(v), 0, get_count()) != get_count();\n\t}\n\n";
+		}
+	}
+
+	void dump_to_string(clang::raw_ostream& out) const
+	{
+		out << "\t// @return name of value or null if value is not valid\n";
+		out << "\tstatic constexpr const char* to_string(Type v)\n\t{\n";
+		if (is_contiguous()) {
+			out << "\t\treturn is_valid(v) ? table<>::names[to_underlying(v) - to_underlying(Type::"
+			    << m_values.front().second << ")] : nullptr;\n\t}\n\n";
+		} else {
+			out << "\t\treturn is_valid(v) ? table<>::names[index_of(to_underlying(v), 0, get_count())] : nullptr;\n\t}\n\n";
+		}
+	}
+
+	void dump_find(clang::raw_ostream& out, const perfect_hash& h) const
+	{
+		out << "\t// @return index of enumerator with given name or get_enumerator_count()\n";
+		out << "\tstatic constexpr std::size_t find(const char* s)\n\t{\n";
+		out << "\t\treturn find_slot(s, table<>::slots[hash(s, " << h.get_seed() << "u) & " << h.get_mask() << "u]);\n\t}\n\n";
+		out << "\t// @brief Gets count of enumerators including aliases\n";
+		out << "\tstatic constexpr std::size_t get_enumerator_count()\n\t{\n";
+		out << "\t\treturn " << m_declared.size() << ";\n\t}\n\n";
+	}
+
+	void dump_from_string(clang::raw_ostream& out) const
+	{
+		out << "\tstatic bool from_string(const char* s, Type& v)\n\t{\n";
+		out << "\t\tconst std::size_t i = find(s);\n";
+		out << "\t\tif (i == get_enumerator_count()) {\n\t\t\treturn false;\n\t\t}\n";
+		out << "\t\tv = table<>::enumerator_values[i];\n";
+		out << "\t\treturn true;\n\t}\n\n";
+	}
+
+	void dump_private(clang::raw_ostream& out, const perfect_hash& h) const
+	{
+		out << "private:\n";
+		out << "\ttemplate <typename D = void>\n\tstruct table\n\t{\n";
+		out << "\t\tstatic constexpr const char* names[] = {";
+		for (auto e : m_values) {
+			out << "\n\t\t\t\"" << e.second << "\",";
+		}
+		out << "\n\t\t};\n";
+		out << "\t\tstatic constexpr Type values[] = {";
+		for (auto e : m_values) {
+			out << "\n\t\t\tType::" << e.second << ",";
+		}
+		out << "\n\t\t};\n";
+		out << "\t\tstatic constexpr const char* enumerator_names[] = {";
+		for (auto e : m_declared) {
+			out << "\n\t\t\t\"" << e.second << "\",";
+		}
+		out << "\n\t\t};\n";
+		out << "\t\tstatic constexpr Type enumerator_values[] = {";
+		for (auto e : m_declared) {
+			out << "\n\t\t\tType::" << e.second << ",";
+		}
+		out << "\n\t\t};\n";
+		out << "\t\tstatic constexpr " << get_slot_type() << " slots[] = {";
+		const perfect_hash::slots& slots = h.get_slots();
+		for (unsigned i = 0; i < slots.size(); ++i) {
+			out << (0 == i % 16 ? "\n\t\t\t" : " ") << slots[i] << ",";
+		}
+		out << "\n\t\t};\n\t};\n\n";
+		out << "\tstatic constexpr underlying_type to_underlying(Type v)\n\t{\n";
+		out << "\t\treturn static_cast<underlying_type>(v);\n\t}\n\n";
+		if (!is_contiguous()) {
+			out << "\tstatic constexpr std::size_t index_of(underlying_type v, std::size_t b, std::size_t e)\n\t{\n";
+			out << "\t\treturn b == e ? get_count() :\n";
+			out << "\t\t       to_underlying(table<>::values[b + (e - b) / 2]) < v ? index_of(v, b + (e - b) / 2 + 1, e) :\n";
+			out << "\t\t       to_underlying(table<>::values[b + (e - b) / 2]) > v ? index_of(v, b, b + (e - b) / 2) :\n";
+			out << "\t\t       b + (e - b) / 2;\n\t}\n\n";
+		}
+		out << "\tstatic constexpr std::uint32_t hash(const char* s, std::uint32_t h)\n\t{\n";
+		out << "\t\treturn '\\0' == *s ? h : hash(s + 1, static_cast<std::uint32_t>((h ^ static_cast<unsigned char>(*s)) * "
+		    << perfect_hash::prime() << "u));\n\t}\n\n";
+		out << "\tstatic constexpr bool equal(const char* s1, const char* s2)\n\t{\n";
+		out << "\t\treturn *s1 == *s2 && ('\\0' == *s1 || equal(s1 + 1, s2 + 1));\n\t}\n\n";
+		out << "\tstatic constexpr std::size_t find_slot(const char* s, std::size_t slot)\n\t{\n";
+		out << "\t\treturn 0 != slot && equal(s, table<>::enumerator_names[slot - 1]) ? slot - 1 : get_enumerator_count();\n\t}\n\n";
+	}
+
+	void dump_table_definitions(clang::raw_ostream& out) const
+	{
+		const std::string table = "reflect<" + get_qualified_name() + ">::table<D>::";
+		out << "template <typename D>\nconstexpr const char* " << table << "names[];\n";
+		out << "template <typename D>\nconstexpr " << get_qualified_name() << " " << table << "values[];\n";
+		out << "template <typename D>\nconstexpr const char* " << table << "enumerator_names[];\n";
+		out << "template <typename D>\nconstexpr " << get_qualified_name() << " " << table << "enumerator_values[];\n";
+		out << "template <typename D>\nconstexpr " << get_slot_type() << " " << table << "slots[];\n\n\n";
+	}
+
+	std::string get_slot_type() const
+	{
+		return m_declared.size() < 0xff ? "std::uint8_t" :
+		       m_declared.size() < 0xffff ? "std::uint16_t" : "std::uint32_t";
+	}
+
+private:
+	source_enum m_source_enum;
+	enumerators m_declared;
+	enumerators m_values;
+}; // class reflected_enum
+
+#endif // REFLECTED_ENUM_HPP
@@ -1,128 +1,625 @@
-/*
-* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
-* Permission is hereby granted, free of charge, to any person obtaining a copy
-* of this software and associated documentation files (the "Software"), to deal
-* in the Software without restriction, including without limitation the rights
-* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-* copies of the Software, and to permit persons to whom the Software is
-* furnished to do so, subject to the following conditions:
-*/
-
-#ifndef REFLECT_OUTPUT_HPP
-#define REFLECT_OUTPUT_HPP
-
-#include "debug.hpp"
-#include "reflect_class.hpp"
-
-#include <llvm/Support/raw_ostream.h>
-
-#include <string>
-
-namespace reflector {
-
-// @class reflect_output
-class reflect_output
-{
-public:
-	explicit reflect_output(llvm::raw_fd_ostream& o)
-		: m_out(o)
-	{
-	}
-
-	void dump(const reflected_class::reflected_collection& reflected)
-	{
-		dump_comments();
-		dump_include_guards_begin();
-		dump_includes();
-		dump_reflect_manager(reflected);
-		dump_forward_delcaration(reflected);
-		dump_reflect_class(reflected);
-		dump_include_guards_end();
-	}
-private:
-	void dump_comments()
-	{
-		m_out << "/*\n";
-		m_out << " ********************************************************\n";
-		m_out << " * This code is licensed see LICENSE.txt for details.\n *\n";
-		m_out << " * This file was generated by 'greflect' tool.\n";
-		m_out << " * Send comments to antonyan_v@outlook.com.\n";
-		m_out << " ********************************************************\n";
-		m_out << "*/\n\n";
-	}
-
-	void dump_include_guards_begin()
-	{
-		m_out << "#ifndef REFLECT_HPP\n";
-		m_out << "#define REFLECT_HPP\n\n";
-	}
-
-	void dump_include_guards_end()
-	{
-		m_out << "#endif // REFLECT_HPP\n";
-	}
-
-	void dump_includes()
-	{
-		m_out << "#include <exception>\n";
-		m_out << "#include <map>\n";
-		m_out << "#include <set>\n";
-		m_out << "#include <string>\n";
-		m_out << "#include <typeinfo>\n";
-		m_out << "\n";
-	}
-
-	void dump_reflect_class_as_template()
-	{
-		m_out << "// @class reflect\n";
-		m_out << "template <typename T>\n";
-		m_out << "class reflect\n{\nprivate:\n";
-		m_out << "\treflect();\n\n";
-		m_out << "\t~reflect();\n\n";
-		m_out << "\treflect(const reflect&);\n\n";
-		m_out << "\treflect& operator =(const reflect&);\n\n\n";
-		m_out << "}; // template class reflect \n\n";
-	}
-
-	void dump_forward_delcaration(const reflected_class::reflected_collection& reflected)
-	{
-		m_out << "// forward declatation\n";
-		for (auto i : reflected) {
-			m_out << "class " << i->get_name() << ";\n";
-		}
-		m_out << "\n";
-	}
-
-	void dump_reflect_class(const reflected_class::reflected_collection& reflected)
-	{
-		dump_reflect_class_as_template();
-		for (auto i : reflected) {
-			i->dump(m_out);
-		}
-	}
-
-	void dump_reflect_manager(const reflected_class::reflected_collection& reflected)
-	{
-		m_out << "// @class reflect_manager\nclass reflect_manager\n{\n";
-		m_out << "public:\n\ttemplate <typename T>\n";
-		m_out << "\tstatic bool is_reflected(const T& o)\n\t{\n";
-		m_out << "\t\tstatic std::set<std::string> reflected_classes;\n";
-		m_out << "\t\t// @note: The additional names for support VC++\n";
-		m_out << "\t\tif (reflected_classes.empty()) {\n";
-		for (auto i : reflected) {
-			std::string name = i->get_name();
-			m_out << "\t\t\treflected_classes.insert(\"" << std::to_string(name.size()) + name << "\");\n";
-			//@note: The additional names for support VC++
-			m_out << "\t\t\treflected_classes.insert(\"class " << name << "\");\n";
-		}
-		m_out << "\t\t}\n\t\treturn reflected_classes.find(typeid(o).name()) != reflected_classes.end();\n\t}\n\n";
-		m_out << "}; // class reflect_manager\n\n";
-	}
-
-private:
-	llvm::raw_fd_ostream& m_out;
-}; // class reflect_output
-
-} // namespace reflector
-
-#endif //REFLECT_OUTPUT_HPP
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef REFLECT_OUTPUT_HPP
+#define REFLECT_OUTPUT_HPP
+
+#include "debug.hpp"
+#include "member_output.hpp"
+#include "profile.hpp"
+#include "reflect_class.hpp"
+#include "reflect_enum.hpp"
+#include "thread_pool.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace reflector {
+
+// @class reflect_output
+class reflect_output
+{
+public:
+	//@brief Kind and name of class for forward declaration.
+	typedef std::pair<std::string, std::string> declaration;
+	typedef std::vector<declaration> declarations;
+	//@brief Names of types returned by std::type_info::name.
+	typedef std::vector<std::string> type_names;
+public:
+	reflect_output(llvm::raw_ostream& o, const profile& p, const std::string& guard)
+		: m_out(o)
+		, m_profile(p)
+		, m_guard(guard)
+		, m_threads(1)
+	{
+	}
+
+	//@brief Minimal number of classes rendered on thread pool.
+	static std::size_t min_parallel_classes()
+	{
+		return 64;
+	}
+
+	//@param count threads rendering classes, 0 means hardware threads
+	void set_threads(unsigned count)
+	{
+		m_threads = count;
+	}
+
+	//@param part declaration_part for header of source output
+	void dump(const reflected_class::reflected_collection& reflected,
+		  const reflected_enum::reflected_collection& enums,
+		  member_output::part part = member_output::inline_part)
+	{
+		declarations ds;
+		type_names ns;
+		for (auto i : reflected) {
+			add_declaration(*i, ds);
+			ns.push_back(i->get_type_name());
+		}
+		dump_begin(ds);
+		dump_reflect_class(reflected, part);
+		dump_end(enums, ns);
+	}
+
+	//@brief Adds forward declaration of class, specializations of
+	//       templates are declared by input.
+	static void add_declaration(const reflected_class& c, declarations& ds)
+	{
+		if (!c.is_template_specialization()) {
+			ds.push_back(declaration(c.get_kind_name(), c.get_name()));
+		}
+	}
+
+	// @note: dump_begin, dump_class for each class and dump_end write the
+	//        same as dump, without keeping all classes at once.
+	void dump_begin(const declarations& ds)
+	{
+		dump_common();
+		dump_include_guards_begin();
+		dump_forward_delcaration(ds);
+	}
+
+	void dump_class(const reflected_class& c, member_output::part part = member_output::inline_part)
+	{
+		c.dump(m_out, m_profile, part);
+	}
+
+	//@param ns type names of all dumped classes
+	void dump_end(const reflected_enum::reflected_collection& enums, const type_names& ns)
+	{
+		dump_reflect_enum(enums);
+		dump_type_names(ns);
+		dump_include_guards_end();
+	}
+
+	//@brief Dumps source file defining members which headers declare.
+	//@param includes input file and generated header
+	void dump_source(const std::vector<std::string>& includes,
+			 const reflected_class::reflected_collection& reflected)
+	{
+		dump_comments();
+		for (auto& i : includes) {
+			m_out << "#include \"" << i << "\"\n";
+		}
+		m_out << "\n";
+		dump_reflect_class(reflected, member_output::definition_part);
+	}
+
+	//@brief Dumps header which includes headers of split output.
+	//@param parts file names relative to directory of this header
+	void dump_umbrella(const std::vector<std::string>& parts)
+	{
+		dump_comments();
+		dump_include_guards_begin();
+		for (auto& p : parts) {
+			m_out << "#include \"" << p << "\"\n";
+		}
+		m_out << "\n";
+		dump_include_guards_end();
+	}
+private:
+	void dump_common()
+	{
+		dump_comments();
+		dump_common_begin();
+		dump_includes();
+		dump_reflect_registry();
+		dump_reflect_dispatcher();
+		dump_reflect_profile();
+		dump_reflect_class_as_template();
+		dump_reflect_manager();
+		dump_common_end();
+	}
+
+	void dump_comments()
+	{
+		m_out << "/*\n";
+		m_out << " ********************************************************\n";
+		m_out << " * This code is licensed see LICENSE.txt for details.\n *\n";
+		m_out << " * This file was generated by 'greflect' tool.\n";
+		m_out << " * Send comments to antonyan_v@outlook.com.\n";
+		m_out << " ********************************************************\n";
+		m_out << "*/\n\n";
+	}
+
+	//@brief Declarations shared by all generated headers.
+	void dump_common_begin()
+	{
+		m_out << "#ifndef GREFLECT_COMMON_HPP\n";
+		m_out << "#define GREFLECT_COMMON_HPP\n\n";
+	}
+
+	void dump_common_end()
+	{
+		m_out << "#endif // GREFLECT_COMMON_HPP\n\n";
+	}
+
+	void dump_include_guards_begin()
+	{
+		m_out << "#ifndef " << m_guard << "\n";
+		m_out << "#define " << m_guard << "\n\n";
+	}
+
+	void dump_include_guards_end()
+	{
+		m_out << "#endif // " << m_guard << "\n";
+	}
+
+	void dump_includes()
+	{
+		m_out << "#include <algorithm>\n";
+		m_out << "#include <cstddef>\n";
+		m_out << "#include <cstdint>\n";
+		m_out << "#include <cstring>\n";
+		m_out << "#include <exception>\n";
+		m_out << "#include <map>\n";
+		m_out << "#include <set>\n";
+		m_out << "#include <stdexcept>\n";
+		m_out << "#include <string>\n";
+		m_out << "#include <type_traits>\n";
+		m_out << "#include <typeinfo>\n";
+		m_out << "#include <utility>\n";
+		m_out << "#include <vector>\n";
+		m_out << "\n";
+	}
+
+	// @note: Each invoke has own counter with atomic count per method, so
+	//        threads calling invoke neither race nor build names. Counters
+	//        are registered once, under lock, dump sums them by name.
+	void dump_reflect_profile()
+	{
+		m_out << "#ifdef REFLECT_PROFILE\n";
+		m_out << "#include <atomic>\n";
+		m_out << "#include <memory>\n";
+		m_out << "#include <mutex>\n";
+		m_out << "#include <ostream>\n";
+		m_out << "#include <vector>\n\n";
+		m_out << "// @class reflect_profile\nclass reflect_profile\n{\n";
+		m_out << "public:\n\ttypedef std::map<std::string, unsigned long> counts;\n\n";
+		m_out << "\t// @class counter\n\t// @brief Calls of methods of one invoke.\n";
+		m_out << "\tclass counter\n\t{\n";
+		m_out << "\tpublic:\n";
+		m_out << "\t\t// @param names sorted names of methods, as for reflect_dispatcher\n";
+		m_out << "\t\tcounter(const char* class_name, const char* const* names, std::size_t count)\n";
+		m_out << "\t\t\t: m_class_name(class_name)\n";
+		m_out << "\t\t\t, m_names(names)\n";
+		m_out << "\t\t\t, m_count(count)\n";
+		m_out << "\t\t\t, m_hits(new std::atomic<unsigned long>[count]())\n";
+		m_out << "\t\t{\n";
+		m_out << "\t\t\tstd::lock_guard<std::mutex> lock(get_mutex());\n";
+		m_out << "\t\t\tget_counters().push_back(this);\n";
+		m_out << "\t\t}\n\n";
+		m_out << "\t\tvoid hit(const char* n)\n\t\t{\n";
+		m_out << "\t\t\tm_hits[reflect_dispatcher::find(m_names, m_count, n)].fetch_add(1, std::memory_order_relaxed);\n";
+		m_out << "\t\t}\n\n";
+		m_out << "\t\tvoid add(counts& c) const\n\t\t{\n";
+		m_out << "\t\t\tfor (std::size_t i = 0; i < m_count; ++i) {\n";
+		m_out << "\t\t\t\tconst unsigned long h = m_hits[i].load(std::memory_order_relaxed);\n";
+		m_out << "\t\t\t\tif (0 != h) {\n";
+		m_out << "\t\t\t\t\tc[std::string(m_class_name) + \"::\" + m_names[i]] += h;\n";
+		m_out << "\t\t\t\t}\n\t\t\t}\n\t\t}\n\n";
+		m_out << "\tprivate:\n";
+		m_out << "\t\tconst char* m_class_name;\n";
+		m_out << "\t\tconst char* const* m_names;\n";
+		m_out << "\t\tstd::size_t m_count;\n";
+		m_out << "\t\tstd::unique_ptr<std::atomic<unsigned long>[]> m_hits;\n";
+		m_out << "\t}; // class counter\n\n";
+		m_out << "\tstatic counts get_counts()\n\t{\n";
+		m_out << "\t\tcounts c;\n";
+		m_out << "\t\tstd::lock_guard<std::mutex> lock(get_mutex());\n";
+		m_out << "\t\tfor (auto i : get_counters()) {\n";
+		m_out << "\t\t\ti->add(c);\n\t\t}\n";
+		m_out << "\t\treturn c;\n\t}\n\n";
+		m_out << "\t// @note: The output is accepted by 'greflect -p'\n";
+		m_out << "\tstatic void dump(std::ostream& out)\n\t{\n";
+		m_out << "\t\tfor (auto i : get_counts()) {\n";
+		m_out << "\t\t\tout << i.first << \" \" << i.second << \"\\n\";\n\t\t}\n\t}\n\n";
+		m_out << "private:\n";
+		m_out << "\tstatic std::mutex& get_mutex()\n\t{\n";
+		m_out << "\t\tstatic std::mutex m;\n\t\treturn m;\n\t}\n\n";
+		m_out << "\tstatic std::vector<const counter*>& get_counters()\n\t{\n";
+		m_out << "\t\tstatic std::vector<const counter*> c;\n\t\treturn c;\n\t}\n";
+		m_out << "}; // class reflect_profile\n";
+		m_out << "#endif // REFLECT_PROFILE\n\n";
+	}
+
+	void dump_reflect_registry()
+	{
+		m_out << "// @note: The registry is a table of pointers in 'greflect_types' linker\n";
+		m_out << "//        section. Each entry is in own COMDAT group, so linker keeps one\n";
+		m_out << "//        copy of it, whatever headers and translation units contain it.\n";
+		m_out << "#if defined(__ELF__) && defined(__GNUC__) && __cplusplus >= 201703L\n";
+		m_out << "#define GREFLECT_REGISTRY 1\n";
+		m_out << "#define GREFLECT_STRING(x) #x\n";
+		m_out << "#define GREFLECT_ALIGN(x) GREFLECT_STRING(x)\n";
+		m_out << "#define GREFLECT_REGISTER(info) \\\n";
+		m_out << "\t__asm__(\".pushsection greflect_types,\\\"awG\\\",%progbits,greflect_entry_\" #info \",comdat\\n\" \\\n";
+		m_out << "\t\t\".balign \" GREFLECT_ALIGN(__SIZEOF_POINTER__) \"\\n.dc.a \" #info \"\\n.popsection\");\n";
+		m_out << "#else\n";
+		m_out << "#define GREFLECT_REGISTRY 0\n";
+		m_out << "#endif // GREFLECT_REGISTRY\n";
+		m_out << "\n";
+		m_out << "// @struct reflect_type_info\n";
+		m_out << "struct reflect_type_info\n";
+		m_out << "{\n";
+		m_out << "\tstd::uint32_t id;\n";
+		m_out << "\tconst char* kind;\n";
+		m_out << "\tconst char* name;\n";
+		m_out << "\tconst char* qualified_name;\n";
+		m_out << "\tconst char* type_name;\n";
+		m_out << "};\n";
+		m_out << "\n";
+		m_out << "#if GREFLECT_REGISTRY\n";
+		m_out << "extern \"C\" {\n";
+		m_out << "extern const reflect_type_info* const __start_greflect_types[] __attribute__((weak));\n";
+		m_out << "extern const reflect_type_info* const __stop_greflect_types[] __attribute__((weak));\n";
+		m_out << "}\n";
+		m_out << "#endif // GREFLECT_REGISTRY\n";
+		m_out << "\n";
+		m_out << "// @class reflect_registry\n";
+		m_out << "class reflect_registry\n";
+		m_out << "{\n";
+		m_out << "public:\n";
+		m_out << "\ttypedef const reflect_type_info* const* iterator;\n";
+		m_out << "\n";
+		m_out << "\tstatic iterator begin()\n";
+		m_out << "\t{\n";
+		m_out << "#if GREFLECT_REGISTRY\n";
+		m_out << "\t\treturn __start_greflect_types;\n";
+		m_out << "#else\n";
+		m_out << "\t\treturn 0;\n";
+		m_out << "#endif // GREFLECT_REGISTRY\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\tstatic iterator end()\n";
+		m_out << "\t{\n";
+		m_out << "#if GREFLECT_REGISTRY\n";
+		m_out << "\t\treturn __stop_greflect_types;\n";
+		m_out << "#else\n";
+		m_out << "\t\treturn 0;\n";
+		m_out << "#endif // GREFLECT_REGISTRY\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\tstatic std::size_t size()\n";
+		m_out << "\t{\n";
+		m_out << "\t\treturn end() - begin();\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\tstatic constexpr std::uint32_t hash(const char* s, std::uint32_t h = 2166136261u)\n";
+		m_out << "\t{\n";
+		m_out << "\t\treturn '\\0' == *s ? h : hash(s + 1, static_cast<std::uint32_t>((h ^ static_cast<unsigned char>(*s)) * 16777619u));\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\tstatic const reflect_type_info* find(std::uint32_t id)\n";
+		m_out << "\t{\n";
+		m_out << "\t\tconst index& x = get_index();\n";
+		m_out << "\t\tconst auto i = std::lower_bound(x.ids.begin(), x.ids.end(), id, less_id);\n";
+		m_out << "\t\treturn i != x.ids.end() && (*i)->id == id ? *i : 0;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\t// @param n qualified name of type\n";
+		m_out << "\tstatic const reflect_type_info* find(const char* n)\n";
+		m_out << "\t{\n";
+		m_out << "\t\tconst std::uint32_t id = hash(n);\n";
+		m_out << "\t\tconst index& x = get_index();\n";
+		m_out << "\t\tfor (auto i = std::lower_bound(x.ids.begin(), x.ids.end(), id, less_id);\n";
+		m_out << "\t\t     i != x.ids.end() && (*i)->id == id; ++i) {\n";
+		m_out << "\t\t\tif (0 == std::strcmp((*i)->qualified_name, n)) {\n";
+		m_out << "\t\t\t\treturn *i;\n";
+		m_out << "\t\t\t}\n";
+		m_out << "\t\t}\n";
+		m_out << "\t\treturn 0;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\t// @param n name returned by std::type_info::name\n";
+		m_out << "\tstatic const reflect_type_info* find_type_name(const char* n)\n";
+		m_out << "\t{\n";
+		m_out << "\t\tconst index& x = get_index();\n";
+		m_out << "\t\tconst auto i = std::lower_bound(x.type_names.begin(), x.type_names.end(), n, less_type_name);\n";
+		m_out << "\t\treturn i != x.type_names.end() && 0 == std::strcmp((*i)->type_name, n) ? *i : 0;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "private:\n";
+		m_out << "\t// @struct index\n";
+		m_out << "\t// @brief Entries sorted by id and by type name.\n";
+		m_out << "\tstruct index\n";
+		m_out << "\t{\n";
+		m_out << "\t\tstd::vector<const reflect_type_info*> ids;\n";
+		m_out << "\t\tstd::vector<const reflect_type_info*> type_names;\n";
+		m_out << "\t};\n";
+		m_out << "\n";
+		m_out << "\t// @note: Built once, on first lookup, so lookups take O(log n) and\n";
+		m_out << "\t//        nothing runs before main.\n";
+		m_out << "\tstatic const index& get_index()\n";
+		m_out << "\t{\n";
+		m_out << "\t\tstatic const index x = make_index();\n";
+		m_out << "\t\treturn x;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\tstatic index make_index()\n";
+		m_out << "\t{\n";
+		m_out << "\t\tindex x;\n";
+		m_out << "\t\tx.ids.assign(begin(), end());\n";
+		m_out << "\t\tstd::stable_sort(x.ids.begin(), x.ids.end(),\n";
+		m_out << "\t\t\t[](const reflect_type_info* i1, const reflect_type_info* i2) { return i1->id < i2->id; });\n";
+		m_out << "\t\tx.type_names.assign(begin(), end());\n";
+		m_out << "\t\tstd::sort(x.type_names.begin(), x.type_names.end(),\n";
+		m_out << "\t\t\t[](const reflect_type_info* i1, const reflect_type_info* i2)\n";
+		m_out << "\t\t\t{\n";
+		m_out << "\t\t\t\treturn std::strcmp(i1->type_name, i2->type_name) < 0;\n";
+		m_out << "\t\t\t}\n";
+		m_out << "\t\t);\n";
+		m_out << "\t\treturn x;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\tstatic bool less_id(const reflect_type_info* i, std::uint32_t id)\n";
+		m_out << "\t{\n";
+		m_out << "\t\treturn i->id < id;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\tstatic bool less_type_name(const reflect_type_info* i, const char* n)\n";
+		m_out << "\t{\n";
+		m_out << "\t\treturn std::strcmp(i->type_name, n) < 0;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "}; // class reflect_registry\n";
+		m_out << "\n";
+	}
+
+	void dump_reflect_dispatcher()
+	{
+		m_out << "#if defined(__GNUC__)\n";
+		m_out << "#define GREFLECT_NOINLINE __attribute__((noinline))\n";
+		m_out << "#else\n";
+		m_out << "#define GREFLECT_NOINLINE\n";
+		m_out << "#endif // __GNUC__\n";
+		m_out << "\n";
+		m_out << "// @class reflect_dispatcher\n";
+		m_out << "// @brief Method lookup shared by all generated invoke functions,\n";
+		m_out << "//        each of them contributes only constant tables of names and\n";
+		m_out << "//        method pointers.\n";
+		m_out << "class reflect_dispatcher\n";
+		m_out << "{\n";
+		m_out << "public:\n";
+		m_out << "\t// @param names sorted names of methods\n";
+		m_out << "\t// @return index of method with name n\n";
+		m_out << "\tGREFLECT_NOINLINE static std::size_t find(const char* const* names, std::size_t count, const char* n)\n";
+		m_out << "\t{\n";
+		m_out << "\t\tconst std::size_t i = search(names, count, n);\n";
+		m_out << "\t\tif (count == i) {\n";
+		m_out << "\t\t\tthrow std::runtime_error(\"Function with name '\" + std::string(n) + \"' not found\");\n";
+		m_out << "\t\t}\n";
+		m_out << "\t\treturn i;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "\t// @param names sorted names\n";
+		m_out << "\t// @return index of name n, or count if there is no such name\n";
+		m_out << "\tstatic std::size_t search(const char* const* names, std::size_t count, const char* n)\n";
+		m_out << "\t{\n";
+		m_out << "\t\tstd::size_t b = 0;\n";
+		m_out << "\t\tstd::size_t e = count;\n";
+		m_out << "\t\twhile (b != e) {\n";
+		m_out << "\t\t\tconst std::size_t m = b + (e - b) / 2;\n";
+		m_out << "\t\t\tconst int r = std::strcmp(names[m], n);\n";
+		m_out << "\t\t\tif (0 == r) {\n";
+		m_out << "\t\t\t\treturn m;\n";
+		m_out << "\t\t\t}\n";
+		m_out << "\t\t\tif (r < 0) {\n";
+		m_out << "\t\t\t\tb = m + 1;\n";
+		m_out << "\t\t\t} else {\n";
+		m_out << "\t\t\t\te = m;\n";
+		m_out << "\t\t\t}\n";
+		m_out << "\t\t}\n";
+		m_out << "\t\treturn count;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "}; // class reflect_dispatcher\n";
+		m_out << "\n";
+		m_out << "\n";
+	}
+
+	void dump_reflect_class_as_template()
+	{
+		m_out << "// @class reflect\n";
+		m_out << "template <typename T>\n";
+		m_out << "class reflect\n{\nprivate:\n";
+		m_out << "\treflect();\n\n";
+		m_out << "\t~reflect();\n\n";
+		m_out << "\treflect(const reflect&);\n\n";
+		m_out << "\treflect& operator =(const reflect&);\n\n\n";
+		m_out << "}; // template class reflect \n\n";
+		m_out << "// @class reflect_template\n";
+		m_out << "// @brief Members shared by reflect of instantiations of one class template.\n";
+		m_out << "template <typename T>\n";
+		m_out << "class reflect_template;\n\n";
+	}
+
+	void dump_forward_delcaration(const declarations& ds)
+	{
+		m_out << "// forward declatation\n";
+		for (auto& i : ds) {
+			m_out << i.first << " " << i.second << ";\n";
+		}
+		m_out << "\n";
+	}
+
+	// @note: Classes of large input are rendered into own chunks on thread
+	//        pool, chunks are written in order of classes, so output does
+	//        not depend on number of threads.
+	void dump_reflect_class(const reflected_class::reflected_collection& reflected, member_output::part part)
+	{
+		const std::vector<reflected_class::ptr> classes(reflected.begin(), reflected.end());
+		std::vector<const reflected_template*> templates;
+		get_first_templates(classes, part, templates);
+		if (1 == m_threads || classes.size() < min_parallel_classes()) {
+			for (std::size_t i = 0; i < classes.size(); ++i) {
+				dump_template_and_class(m_out, m_profile, templates[i], *classes[i], part);
+			}
+			return;
+		}
+		std::vector<std::string> chunks(classes.size());
+		const profile& p = m_profile;
+		thread_pool(m_threads).for_each_rethrow(classes.size(),
+			[&classes, &templates, &chunks, &p, part](unsigned, std::size_t i)
+			{
+				llvm::raw_string_ostream out(chunks[i]);
+				dump_template_and_class(out, p, templates[i], *classes[i], part);
+				out.flush();
+			}
+		);
+		for (auto& c : chunks) {
+			m_out << c;
+		}
+	}
+
+	//@param t shared body to dump before class, or null
+	static void dump_template_and_class(llvm::raw_ostream& out, const profile& p, const reflected_template* t,
+					    const reflected_class& c, member_output::part part)
+	{
+		if (0 != t) {
+			t->dump(out, p);
+		}
+		c.dump(out, p, part);
+	}
+
+	//@brief Gets shared body of each class, only for the first class which
+	//       shares it. Source output defines no shared bodies.
+	static void get_first_templates(const std::vector<reflected_class::ptr>& classes, member_output::part part,
+					std::vector<const reflected_template*>& templates)
+	{
+		std::set<const reflected_template*> dumped;
+		for (auto& c : classes) {
+			const reflected_template* t = c->get_template().get();
+			const bool first = 0 != t && member_output::definition_part != part && dumped.insert(t).second;
+			templates.push_back(first ? t : 0);
+		}
+	}
+
+	void dump_reflect_enum(const reflected_enum::reflected_collection& enums)
+	{
+		for (auto i : enums) {
+			i->dump(m_out);
+		}
+	}
+
+	// @note: Without registry each generated header adds sorted table of
+	//        type names of its classes, dynamic type of object is searched
+	//        in all of them.
+	void dump_reflect_manager()
+	{
+		m_out << "// @class reflect_manager\n";
+		m_out << "class reflect_manager\n";
+		m_out << "{\n";
+		m_out << "public:\n";
+		m_out << "\ttemplate <typename T>\n";
+		m_out << "\tstatic bool is_reflected(const T& o)\n";
+		m_out << "\t{\n";
+		m_out << "#if GREFLECT_REGISTRY\n";
+		m_out << "\t\treturn 0 != reflect_registry::find_type_name(typeid(o).name());\n";
+		m_out << "#else\n";
+		m_out << "\t\tconst char* n = typeid(o).name();\n";
+		m_out << "\t\tfor (auto& t : get_tables()) {\n";
+		m_out << "\t\t\tif (t.second != reflect_dispatcher::search(t.first, t.second, n)) {\n";
+		m_out << "\t\t\t\treturn true;\n";
+		m_out << "\t\t\t}\n";
+		m_out << "\t\t}\n";
+		m_out << "\t\treturn false;\n";
+		m_out << "#endif // GREFLECT_REGISTRY\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "#if !GREFLECT_REGISTRY\n";
+		m_out << "\t// @param names sorted names returned by std::type_info::name\n";
+		m_out << "\tstatic bool add_type_names(const char* const* names, std::size_t count)\n";
+		m_out << "\t{\n";
+		m_out << "\t\tfor (auto& t : get_tables()) {\n";
+		m_out << "\t\t\tif (t.first == names) {\n";
+		m_out << "\t\t\t\treturn false;\n";
+		m_out << "\t\t\t}\n";
+		m_out << "\t\t}\n";
+		m_out << "\t\tget_tables().push_back(table(names, count));\n";
+		m_out << "\t\treturn true;\n";
+		m_out << "\t}\n";
+		m_out << "\n";
+		m_out << "private:\n";
+		m_out << "\ttypedef std::pair<const char* const*, std::size_t> table;\n";
+		m_out << "\n";
+		m_out << "\tstatic std::vector<table>& get_tables()\n";
+		m_out << "\t{\n";
+		m_out << "\t\tstatic std::vector<table> t;\n";
+		m_out << "\t\treturn t;\n";
+		m_out << "\t}\n";
+		m_out << "#endif // GREFLECT_REGISTRY\n";
+		m_out << "\n";
+		m_out << "}; // class reflect_manager\n";
+		m_out << "\n";
+	}
+
+	// @note: The table is static of inline function, so all translation
+	//        units add the same one, only once.
+	void dump_type_names(type_names ns)
+	{
+		if (ns.empty()) {
+			return;
+		}
+		std::sort(ns.begin(), ns.end());
+		const std::string name = "greflect_type_names_" + m_guard;
+		m_out << "#if !GREFLECT_REGISTRY\n";
+		m_out << "inline const char* const* " << name << "()\n";
+		m_out << "{\n";
+		m_out << "\tstatic const char* const names[] = {\n";
+		for (auto& n : ns) {
+			m_out << "\t\t\"" << n << "\",\n";
+		}
+		m_out << "\t};\n";
+		m_out << "\treturn names;\n";
+		m_out << "}\n";
+		m_out << "\n";
+		m_out << "static const bool " << name << "_added = reflect_manager::add_type_names(" << name << "(), "
+		      << ns.size() << ");\n";
+		m_out << "#endif // GREFLECT_REGISTRY\n";
+		m_out << "\n";
+	}
+
+private:
+	llvm::raw_ostream& m_out;
+	const profile& m_profile;
+	std::string m_guard;
+	unsigned m_threads;
+}; // class reflect_output
+
+} // namespace reflector
+
+#endif //REFLECT_OUTPUT_HPP
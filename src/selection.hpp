@@ -0,0 +1,176 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef SELECTION_HPP
+#define SELECTION_HPP
+
+#include "debug.hpp"
+
+#include <clang/AST/Attr.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclCXX.h>
+
+#include <fstream>
+#include <memory>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
+namespace reflector {
+
+// @class selection
+// @brief Decides which types and members are reflected. Declarations are
+//        marked by __attribute__((annotate("reflect"))) or
+//        __attribute__((annotate("noreflect"))). Annotated member selects
+//        its class and leaves out its unannotated members. Exclude list
+//        has qualified names of types and 'Type::member' names, one per
+//        line, name ending with '*' matches prefix.
+class selection
+{
+public:
+	typedef std::shared_ptr<const selection> ptr;
+
+	// @struct skipped
+	// @brief Counts of declarations left out by selection.
+	struct skipped
+	{
+		unsigned classes;
+		unsigned enums;
+		unsigned methods;
+		unsigned fields;
+	}; // struct skipped
+private:
+	typedef std::set<std::string> names;
+public:
+	selection()
+		: m_annotated_only(false)
+	{
+	}
+
+	//@brief Reflects only annotated types and types with annotated members.
+	void set_annotated_only(bool a)
+	{
+		m_annotated_only = a;
+	}
+
+	void load_exclude_list(const std::string& file_name)
+	{
+		std::ifstream in(file_name.c_str());
+		if (!in) {
+			throw std::runtime_error("Can not open exclude list '" + file_name + "'");
+		}
+		m_exclude_file_name = file_name;
+		std::string line;
+		while (std::getline(in, line)) {
+			const std::string::size_type b = line.find_first_not_of(" \t");
+			if (std::string::npos == b || '#' == line[b]) {
+				continue;
+			}
+			const std::string n = line.substr(b, line.find_last_not_of(" \t\r") + 1 - b);
+			if ('*' == n[n.size() - 1]) {
+				m_excluded_prefixes.insert(n.substr(0, n.size() - 1));
+			} else {
+				m_excluded.insert(n);
+			}
+		}
+	}
+
+	const std::string& get_exclude_file_name() const
+	{
+		return m_exclude_file_name;
+	}
+
+	//@brief Gets everything selection depends on, for cache key.
+	std::string get_key() const
+	{
+		std::ostringstream key;
+		key << m_annotated_only;
+		for (auto& n : m_excluded) {
+			key << '\0' << n;
+		}
+		for (auto& n : m_excluded_prefixes) {
+			key << '\0' << n << '*';
+		}
+		return key.str();
+	}
+
+	bool is_selected(const clang::CXXRecordDecl* d) const
+	{
+		ASSERT(0 != d);
+		if (has_annotation(d, "noreflect") || is_excluded(d->getQualifiedNameAsString())) {
+			return false;
+		}
+		return !m_annotated_only || has_annotation(d, "reflect") || has_annotated_members(d);
+	}
+
+	bool is_selected(const clang::EnumDecl* d) const
+	{
+		ASSERT(0 != d);
+		if (has_annotation(d, "noreflect") || is_excluded(d->getQualifiedNameAsString())) {
+			return false;
+		}
+		return !m_annotated_only || has_annotation(d, "reflect");
+	}
+
+	//@brief Checks method or field of selected class.
+	bool is_selected_member(const clang::NamedDecl* m, const std::string& class_name, bool has_annotated_members) const
+	{
+		ASSERT(0 != m);
+		if (has_annotation(m, "noreflect") || is_excluded(class_name + "::" + m->getNameAsString())) {
+			return false;
+		}
+		return !has_annotated_members || has_annotation(m, "reflect");
+	}
+
+	static bool has_annotated_members(const clang::CXXRecordDecl* d)
+	{
+		for (auto m : d->decls()) {
+			if (has_annotation(m, "reflect")) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	static bool has_annotation(const clang::Decl* d, const char* annotation)
+	{
+		for (auto a : d->specific_attrs<clang::AnnotateAttr>()) {
+			if (a->getAnnotation() == annotation) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	bool is_excluded(const std::string& name) const
+	{
+		if (0 != m_excluded.count(name)) {
+			return true;
+		}
+		for (auto& p : m_excluded_prefixes) {
+			if (0 == name.compare(0, p.size(), p)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+private:
+	bool m_annotated_only;
+	std::string m_exclude_file_name;
+	names m_excluded;
+	names m_excluded_prefixes;
+}; // class selection
+
+} // namespace reflector
+
+#endif // SELECTION_HPP
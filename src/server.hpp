@@ -0,0 +1,240 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef SERVER_HPP
+#define SERVER_HPP
+
+#include "messenger.hpp"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// @note: Protocol of greflect server. Client connects to Unix socket, sends
+//        its working directory and greflect arguments, each terminated by
+//        '\0', and shuts down writing. Server replies with exit code line
+//        followed by messages of run, and closes connection when outputs
+//        are up to date. Request must come within request_timeout, reply
+//        is dropped when client does not take it as long. Socket is
+//        accessible only by user of server, and connections of other
+//        users are refused.
+namespace reflector {
+
+// @class server
+// @brief Runs requests of greflect client in one long living process, so
+//        compiler state and precompiled headers stay warm between them.
+//        Requests are run one by one.
+class server
+{
+public:
+	typedef std::vector<std::string> strings;
+public:
+	explicit server(const std::string& socket_name)
+		: m_socket_name(socket_name)
+		, m_fd(-1)
+	{
+		sockaddr_un address = get_address();
+		if (is_running(address)) {
+			throw std::runtime_error("Server is already running on '" + socket_name + "'");
+		}
+		m_fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (-1 == m_fd) {
+			throw std::runtime_error(std::string("Can not create socket: ") + std::strerror(errno));
+		}
+		::unlink(socket_name.c_str());
+		// @note: Socket is created with mode 0600, requests change directory
+		//        and write files as user of server.
+		const mode_t mask = ::umask(0177);
+		const bool bound = 0 == ::bind(m_fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+		::umask(mask);
+		if (!bound || 0 != ::listen(m_fd, SOMAXCONN)) {
+			const std::string error = std::strerror(errno);
+			::close(m_fd);
+			throw std::runtime_error("Can not listen on '" + socket_name + "': " + error);
+		}
+	}
+
+	//@brief Gets seconds client has to send request, or take reply, so one
+	//       stuck client does not block others.
+	static int request_timeout()
+	{
+		return 10;
+	}
+
+	~server()
+	{
+		::close(m_fd);
+		::unlink(m_socket_name.c_str());
+	}
+
+	//@brief Serves requests until error of socket.
+	//@param h int h(int argc, char const **argv) runs one request
+	template <typename Handler>
+	int run(Handler h)
+	{
+		massenger::print("Listening on " + m_socket_name);
+		for (;;) {
+			const int c = ::accept(m_fd, 0, 0);
+			if (-1 == c) {
+				if (EINTR == errno) {
+					continue;
+				}
+				massenger::error(std::string("Can not accept connection: ") + std::strerror(errno));
+				return 1;
+			}
+			strings request;
+			if (!is_same_user(c)) {
+				massenger::worrning("Refused connection of other user");
+			} else if (!read_request(c, request)) {
+				massenger::worrning("Dropped request which did not come in time or was broken");
+			} else if (!request.empty()) {
+				write_reply(c, serve(request, h));
+			}
+			::close(c);
+		}
+	}
+
+private:
+	template <typename Handler>
+	std::string serve(const strings& request, Handler h) const
+	{
+		std::ostringstream messages;
+		massenger::redirect(&messages);
+		int code = 1;
+		if (0 != ::chdir(request.front().c_str())) {
+			massenger::error("Can not change directory to '" + request.front() + "'");
+		} else {
+			std::vector<const char*> argv(1, "greflect");
+			for (std::size_t i = 1; i < request.size(); ++i) {
+				argv.push_back(request[i].c_str());
+			}
+			try {
+				code = h(static_cast<int>(argv.size()), argv.data());
+			} catch (const std::exception& e) {
+				massenger::error(e.what());
+			} catch (...) {
+				massenger::error("Unhandled exception");
+			}
+		}
+		massenger::redirect(0);
+		std::ostringstream reply;
+		reply << code << "\n" << messages.str();
+		return reply.str();
+	}
+
+	static bool read_request(int fd, strings& request)
+	{
+		typedef std::chrono::steady_clock clock;
+		const clock::time_point deadline = clock::now() + std::chrono::seconds(request_timeout());
+		std::string data;
+		char buffer[4096];
+		for (;;) {
+			const long left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - clock::now()).count();
+			pollfd p = { fd, POLLIN, 0 };
+			const int ready = left <= 0 ? 0 : ::poll(&p, 1, static_cast<int>(left));
+			if (ready < 0 && EINTR == errno) {
+				continue;
+			}
+			if (ready <= 0) {
+				return false;
+			}
+			const ssize_t n = ::read(fd, buffer, sizeof(buffer));
+			if (0 == n) {
+				break;
+			}
+			if (n < 0) {
+				if (EINTR == errno) {
+					continue;
+				}
+				return false;
+			}
+			data.append(buffer, n);
+		}
+		std::string::size_type b = 0;
+		for (std::string::size_type e = data.find('\0'); std::string::npos != e; e = data.find('\0', b)) {
+			request.push_back(data.substr(b, e - b));
+			b = e + 1;
+		}
+		return true;
+	}
+
+	static void write_reply(int fd, const std::string& reply)
+	{
+		const timeval timeout = { request_timeout(), 0 };
+		::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+		std::string::size_type written = 0;
+		while (written < reply.size()) {
+			const ssize_t n = ::send(fd, reply.data() + written, reply.size() - written, MSG_NOSIGNAL);
+			if (n < 0 && EINTR == errno) {
+				continue;
+			}
+			if (n <= 0) {
+				return;
+			}
+			written += n;
+		}
+	}
+
+	static bool is_same_user(int fd)
+	{
+		ucred credentials;
+		socklen_t size = sizeof(credentials);
+		return 0 == ::getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &credentials, &size) &&
+		       ::geteuid() == credentials.uid;
+	}
+
+	//@brief Checks whether other server accepts connections, otherwise
+	//       the socket file is left by crashed one.
+	static bool is_running(sockaddr_un& address)
+	{
+		const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		const bool r = -1 != fd && 0 == ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address));
+		if (-1 != fd) {
+			::close(fd);
+		}
+		return r;
+	}
+
+	sockaddr_un get_address() const
+	{
+		sockaddr_un address;
+		std::memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (m_socket_name.size() >= sizeof(address.sun_path)) {
+			throw std::runtime_error("Socket name '" + m_socket_name + "' is too long");
+		}
+		std::strcpy(address.sun_path, m_socket_name.c_str());
+		return address;
+	}
+
+private:
+	server(const server&);
+	server& operator =(const server&);
+
+private:
+	std::string m_socket_name;
+	int m_fd;
+}; // class server
+
+} // namespace reflector
+
+#endif // SERVER_HPP
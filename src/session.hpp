@@ -0,0 +1,54 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef SESSION_HPP
+#define SESSION_HPP
+
+#include "cache.hpp"
+#include "precompiled_header.hpp"
+
+#include <map>
+#include <memory>
+#include <string>
+
+namespace reflector {
+
+// @class session
+// @brief State kept by server between requests. Precompiled headers stay
+//        built in memory and in temporary files and are only revalidated
+//        by next request which uses them.
+class session
+{
+private:
+	typedef std::map<std::string, precompiled_header::ptr> precompiled_headers;
+public:
+	//@brief Gets precompiled header of earlier request or creates new one.
+	//@param header absolute file name
+	//@param cache_directory directory of c, empty without cache
+	precompiled_header::ptr get_precompiled_header(const std::string& header, const cache::ptr& c,
+						       const std::string& cache_directory)
+	{
+		const std::string key = header + '\0' + cache_directory;
+		precompiled_headers::const_iterator i = m_precompiled_headers.find(key);
+		if (i != m_precompiled_headers.end()) {
+			return i->second;
+		}
+		precompiled_header::ptr p = std::make_shared<precompiled_header>(header, c);
+		m_precompiled_headers[key] = p;
+		return p;
+	}
+
+private:
+	precompiled_headers m_precompiled_headers;
+}; // class session
+
+} // namespace reflector
+
+#endif // SESSION_HPP
@@ -0,0 +1,120 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef STAT_CACHE_HPP
+#define STAT_CACHE_HPP
+
+#include <clang/Basic/VirtualFileSystem.h>
+#include <llvm/ADT/IntrusiveRefCntPtr.h>
+#include <llvm/ADT/Twine.h>
+#include <llvm/Support/ErrorOr.h>
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace reflector {
+
+// @class stat_cache
+// @brief Results of stat and failed opens, shared by all workers.
+//        Header search probes the same missing paths for every input,
+//        so most of hits are negative.
+class stat_cache
+{
+public:
+	typedef llvm::ErrorOr<clang::vfs::Status> status;
+	typedef std::shared_ptr<stat_cache> ptr;
+private:
+	typedef std::map<std::string, status> path_to_status;
+public:
+	bool find(const std::string& path, status& s) const
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		path_to_status::const_iterator i = m_statuses.find(path);
+		if (i == m_statuses.end()) {
+			return false;
+		}
+		s = i->second;
+		return true;
+	}
+
+	void insert(const std::string& path, const status& s)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_statuses.insert(std::make_pair(path, s));
+	}
+
+private:
+	mutable std::mutex m_mutex;
+	path_to_status m_statuses;
+}; // class stat_cache
+
+// @class stat_cache_file_system
+// @brief Real file system which remembers results in shared stat_cache.
+//        Each compiler instance has own object of it.
+class stat_cache_file_system : public clang::vfs::FileSystem
+{
+public:
+	explicit stat_cache_file_system(const stat_cache::ptr& c)
+		: m_cache(c)
+		, m_base(clang::vfs::getRealFileSystem())
+	{
+	}
+
+	llvm::ErrorOr<clang::vfs::Status> status(const llvm::Twine& path) override
+	{
+		const std::string p = path.str();
+		stat_cache::status s = std::make_error_code(std::errc::no_such_file_or_directory);
+		if (m_cache->find(p, s)) {
+			return s;
+		}
+		s = m_base->status(p);
+		m_cache->insert(p, s);
+		return s;
+	}
+
+	llvm::ErrorOr<std::unique_ptr<clang::vfs::File> > openFileForRead(const llvm::Twine& path) override
+	{
+		const std::string p = path.str();
+		stat_cache::status s = std::make_error_code(std::errc::no_such_file_or_directory);
+		if (m_cache->find(p, s) && !s) {
+			return s.getError();
+		}
+		llvm::ErrorOr<std::unique_ptr<clang::vfs::File> > f = m_base->openFileForRead(p);
+		if (!f) {
+			m_cache->insert(p, f.getError());
+		}
+		return f;
+	}
+
+	clang::vfs::directory_iterator dir_begin(const llvm::Twine& dir, std::error_code& ec) override
+	{
+		return m_base->dir_begin(dir, ec);
+	}
+
+	llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override
+	{
+		return m_base->getCurrentWorkingDirectory();
+	}
+
+	std::error_code setCurrentWorkingDirectory(const llvm::Twine& path) override
+	{
+		return m_base->setCurrentWorkingDirectory(path);
+	}
+
+private:
+	stat_cache::ptr m_cache;
+	llvm::IntrusiveRefCntPtr<clang::vfs::FileSystem> m_base;
+}; // class stat_cache_file_system
+
+} // namespace reflector
+
+#endif // STAT_CACHE_HPP
@@ -0,0 +1,327 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+#include "debug.hpp"
+#include "model.hpp"
+#include "selection.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+namespace reflector {
+
+// @class statistics
+// @brief Times of phases and counts of one input, or sum of several
+//        inputs, reported by --stats.
+class statistics
+{
+public:
+	enum phase {
+		phase_setup,
+		phase_parse,
+		phase_traversal,
+		phase_extraction,
+		phase_emission,
+		phase_count,
+		phase_none = phase_count
+	};
+
+	typedef std::chrono::steady_clock clock;
+	typedef std::map<std::string, unsigned> reasons;
+	typedef std::vector<std::pair<std::string, unsigned> > class_methods;
+
+	// @class timer
+	// @brief Charges time of its scope to phase. Nested timer pauses outer
+	//        one, so each phase gets only its own time.
+	class timer
+	{
+	public:
+		timer(statistics& s, phase p)
+			: m_stats(s)
+			, m_outer(s.switch_to(p))
+		{
+		}
+
+		~timer()
+		{
+			m_stats.switch_to(m_outer);
+		}
+	private:
+		timer(const timer&);
+		timer& operator=(const timer&);
+	private:
+		statistics& m_stats;
+		phase m_outer;
+	}; // class timer
+public:
+	statistics()
+		: m_inputs(0)
+		, m_cached_inputs(0)
+		, m_visited_classes(0)
+		, m_reflected_classes(0)
+		, m_reflected_enums(0)
+		, m_reflected_methods(0)
+		, m_reflected_fields(0)
+		, m_skipped()
+		, m_generated_bytes(0)
+		, m_written_bytes(0)
+		, m_current(phase_none)
+	{
+		for (auto& t : m_times) {
+			t = clock::duration::zero();
+		}
+	}
+
+	//@brief Checks that nothing is counted, e.g. input failed.
+	bool empty() const
+	{
+		return 0 == m_inputs;
+	}
+
+	static const char* get_phase_name(phase p)
+	{
+		static const char* const names[phase_count] = {
+			"setup", "parse", "traversal", "extraction", "emission"
+		};
+		ASSERT(p < phase_count);
+		return names[p];
+	}
+
+	//@brief Gets peak resident memory of process in kilobytes.
+	static long get_peak_memory()
+	{
+		rusage u;
+		return 0 == ::getrusage(RUSAGE_SELF, &u) ? u.ru_maxrss : 0;
+	}
+
+	double get_seconds(phase p) const
+	{
+		ASSERT(p < phase_count);
+		return std::chrono::duration<double>(m_times[p]).count();
+	}
+
+	void set_input(const std::string& file_name, bool cached)
+	{
+		m_input_file_name = file_name;
+		m_inputs = 1;
+		m_cached_inputs = cached ? 1 : 0;
+	}
+
+	//@brief Counts class definition of main file seen by visitor.
+	void add_visited_class()
+	{
+		++m_visited_classes;
+	}
+
+	//@brief Counts class or enum which is not reflected.
+	void add_skipped(const std::string& reason)
+	{
+		++m_skip_reasons[reason];
+	}
+
+	//@brief Counts reflected types and members of model.
+	void add(const model::unit& u)
+	{
+		m_reflected_enums += u.enums.size();
+		for (auto& c : u.classes) {
+			add(c);
+		}
+	}
+
+	void add(const model::record& c)
+	{
+		++m_reflected_classes;
+		m_reflected_methods += c.methods.size();
+		for (auto& f : c.fields) {
+			m_reflected_fields += f.is_selected ? 1 : 0;
+		}
+		m_class_methods.push_back(std::make_pair(c.qualified_name, c.methods.size()));
+	}
+
+	//@brief Counts declarations left out by selection.
+	void add(const selection::skipped& k)
+	{
+		m_skipped.classes += k.classes;
+		m_skipped.enums += k.enums;
+		m_skipped.methods += k.methods;
+		m_skipped.fields += k.fields;
+	}
+
+	//@param written false if file had the same content
+	void add_output(std::size_t bytes, bool written)
+	{
+		m_generated_bytes += bytes;
+		m_written_bytes += written ? bytes : 0;
+	}
+
+	//@brief Adds statistics of another input.
+	void merge(const statistics& s)
+	{
+		for (unsigned p = 0; p < phase_count; ++p) {
+			m_times[p] += s.m_times[p];
+		}
+		m_inputs += s.m_inputs;
+		m_cached_inputs += s.m_cached_inputs;
+		m_visited_classes += s.m_visited_classes;
+		m_reflected_classes += s.m_reflected_classes;
+		m_reflected_enums += s.m_reflected_enums;
+		m_reflected_methods += s.m_reflected_methods;
+		m_reflected_fields += s.m_reflected_fields;
+		add(s.m_skipped);
+		for (auto& r : s.m_skip_reasons) {
+			m_skip_reasons[r.first] += r.second;
+		}
+		m_class_methods.insert(m_class_methods.end(), s.m_class_methods.begin(), s.m_class_methods.end());
+		m_generated_bytes += s.m_generated_bytes;
+		m_written_bytes += s.m_written_bytes;
+	}
+
+	//@brief Writes human readable report.
+	//@param wall elapsed time of all inputs, less than sum of phases
+	//       when inputs run in parallel
+	void dump_text(std::ostream& out, double wall) const
+	{
+		out << "Statistics of " << m_inputs << " inputs, " << m_cached_inputs << " from cache:\n";
+		for (unsigned p = 0; p < phase_count; ++p) {
+			out << "  " << get_phase_name(static_cast<phase>(p)) << ": "
+			    << format_seconds(get_seconds(static_cast<phase>(p))) << " s\n";
+		}
+		out << "  wall: " << format_seconds(wall) << " s\n";
+		unsigned skipped = 0;
+		for (auto& r : m_skip_reasons) {
+			skipped += r.second;
+		}
+		out << "  types: " << m_visited_classes << " classes visited, " << m_reflected_classes << " classes and "
+		    << m_reflected_enums << " enums reflected, " << skipped << " skipped\n";
+		for (auto& r : m_skip_reasons) {
+			out << "    " << r.first << ": " << r.second << "\n";
+		}
+		out << "  methods: " << m_reflected_methods << " reflected, " << m_skipped.methods << " left out";
+		const class_methods::const_iterator m = get_most_methods();
+		if (m != m_class_methods.end()) {
+			out << ", at most " << m->second << " in '" << m->first << "'";
+		}
+		out << "\n  fields: " << m_reflected_fields << " reflected, " << m_skipped.fields << " left out\n";
+		out << "  output: " << m_generated_bytes << " bytes generated, " << m_written_bytes << " bytes written\n";
+		out << "  peak memory: " << get_peak_memory() << " KB";
+	}
+
+	//@brief Writes JSON object of this input, or of sum without file name.
+	void dump_json(std::ostream& out) const
+	{
+		out << "{";
+		if (!m_input_file_name.empty()) {
+			out << "\"file\": \"" << escape(m_input_file_name) << "\", ";
+		}
+		out << "\"inputs\": " << m_inputs << ", \"cached_inputs\": " << m_cached_inputs << ", \"seconds\": {";
+		for (unsigned p = 0; p < phase_count; ++p) {
+			out << (0 == p ? "" : ", ") << "\"" << get_phase_name(static_cast<phase>(p)) << "\": "
+			    << format_seconds(get_seconds(static_cast<phase>(p)));
+		}
+		out << "}, \"classes\": {\"visited\": " << m_visited_classes << ", \"reflected\": " << m_reflected_classes
+		    << ", \"left_out\": " << m_skipped.classes << "}, \"enums\": {\"reflected\": " << m_reflected_enums
+		    << ", \"left_out\": " << m_skipped.enums << "}, \"skip_reasons\": {";
+		const char* separator = "";
+		for (auto& r : m_skip_reasons) {
+			out << separator << "\"" << escape(r.first) << "\": " << r.second;
+			separator = ", ";
+		}
+		out << "}, \"methods\": {\"reflected\": " << m_reflected_methods << ", \"left_out\": " << m_skipped.methods
+		    << "}, \"fields\": {\"reflected\": " << m_reflected_fields << ", \"left_out\": " << m_skipped.fields
+		    << "}, \"methods_per_class\": {";
+		separator = "";
+		for (auto& c : m_class_methods) {
+			out << separator << "\"" << escape(c.first) << "\": " << c.second;
+			separator = ", ";
+		}
+		out << "}, \"generated_bytes\": " << m_generated_bytes << ", \"written_bytes\": " << m_written_bytes << "}";
+	}
+
+	static std::string format_seconds(double s)
+	{
+		char buffer[32];
+		std::snprintf(buffer, sizeof(buffer), "%.6f", s);
+		return buffer;
+	}
+
+	static std::string escape(const std::string& s)
+	{
+		std::string r;
+		for (auto c : s) {
+			if ('"' == c || '\\' == c) {
+				r += '\\';
+				r += c;
+			} else if (static_cast<unsigned char>(c) < 0x20) {
+				char buffer[8];
+				std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+				r += buffer;
+			} else {
+				r += c;
+			}
+		}
+		return r;
+	}
+private:
+	//@brief Stops current phase and starts given one.
+	//@return Stopped phase.
+	phase switch_to(phase p)
+	{
+		const clock::time_point now = clock::now();
+		if (phase_none != m_current) {
+			m_times[m_current] += now - m_start;
+		}
+		m_start = now;
+		std::swap(m_current, p);
+		return p;
+	}
+
+	class_methods::const_iterator get_most_methods() const
+	{
+		class_methods::const_iterator m = m_class_methods.end();
+		for (class_methods::const_iterator i = m_class_methods.begin(); i != m_class_methods.end(); ++i) {
+			if (m == m_class_methods.end() || m->second < i->second) {
+				m = i;
+			}
+		}
+		return m;
+	}
+
+private:
+	std::string m_input_file_name;
+	unsigned m_inputs;
+	unsigned m_cached_inputs;
+	unsigned m_visited_classes;
+	unsigned m_reflected_classes;
+	unsigned m_reflected_enums;
+	unsigned m_reflected_methods;
+	unsigned m_reflected_fields;
+	selection::skipped m_skipped;
+	reasons m_skip_reasons;
+	class_methods m_class_methods;
+	std::size_t m_generated_bytes;
+	std::size_t m_written_bytes;
+	clock::duration m_times[phase_count];
+	phase m_current;
+	clock::time_point m_start;
+}; // class statistics
+
+} // namespace reflector
+
+#endif // STATISTICS_HPP
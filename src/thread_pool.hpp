@@ -0,0 +1,100 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef THREAD_POOL_HPP
+#define THREAD_POOL_HPP
+
+#include "debug.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace reflector {
+
+// @class thread_pool
+class thread_pool
+{
+public:
+	//@param count number of threads, 0 means number of hardware threads
+	explicit thread_pool(unsigned count)
+		: m_count(0 == count ? std::max(1u, std::thread::hardware_concurrency()) : count)
+	{
+	}
+
+	unsigned get_count() const
+	{
+		return m_count;
+	}
+
+	//@brief Calls f(worker, index) for each index in [0, size), each
+	//       worker takes the next index when it finishes the previous.
+	//       Functor must not throw.
+	template <typename Functor>
+	void for_each(std::size_t size, Functor f) const
+	{
+		std::atomic<std::size_t> next(0);
+		const unsigned count = static_cast<unsigned>(std::min<std::size_t>(m_count, size));
+		if (count <= 1) {
+			for (std::size_t i = 0; i < size; ++i) {
+				f(0u, i);
+			}
+			return;
+		}
+		std::vector<std::thread> workers;
+		for (unsigned w = 0; w < count; ++w) {
+			workers.push_back(std::thread(
+				[&next, &f, size, w]()
+				{
+					for (std::size_t i = next++; i < size; i = next++) {
+						f(w, i);
+					}
+				}
+			));
+		}
+		for (auto& t : workers) {
+			t.join();
+		}
+	}
+
+	//@brief Calls f(worker, index) as for_each does, but functor may throw.
+	//       After all indices are done the exception of the lowest index
+	//       is thrown again.
+	template <typename Functor>
+	void for_each_rethrow(std::size_t size, Functor f) const
+	{
+		std::vector<std::exception_ptr> errors(size);
+		for_each(size,
+			[&errors, &f](unsigned w, std::size_t i)
+			{
+				try {
+					f(w, i);
+				} catch (...) {
+					errors[i] = std::current_exception();
+				}
+			}
+		);
+		for (auto& e : errors) {
+			if (e) {
+				std::rethrow_exception(e);
+			}
+		}
+	}
+
+private:
+	unsigned m_count;
+}; // class thread_pool
+
+} // namespace reflector
+
+#endif // THREAD_POOL_HPP
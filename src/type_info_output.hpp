@@ -0,0 +1,80 @@
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef TYPE_INFO_OUTPUT_HPP
+#define TYPE_INFO_OUTPUT_HPP
+
+#include "member_output.hpp"
+#include "utils.hpp"
+
+#include <llvm/Support/raw_ostream.h>
+
+#include <string>
+
+//@class type_info_output
+//@brief Dumps reflect_type_info of one type and its registry entry.
+class type_info_output
+{
+public:
+	type_info_output(const std::string& kind, const std::string& name,
+			 const std::string& qualified_name, const std::string& type_name)
+		: m_kind(kind)
+		, m_name(name)
+		, m_qualified_name(qualified_name)
+		, m_type_name(type_name)
+	{
+	}
+
+	//@brief Dumps namespace scope entry of global registry.
+	void dump_entry(clang::raw_ostream& out) const
+	{
+		out << "#if GREFLECT_REGISTRY\n";
+		out << "__attribute__((used)) inline constexpr reflect_type_info " << get_variable_name() << " = {\n";
+		dump_initializer(out, "\t");
+		out << "};\n";
+		out << "GREFLECT_REGISTER(" << get_variable_name() << ")\n";
+		out << "#endif // GREFLECT_REGISTRY\n\n";
+	}
+
+	//@brief Dumps static get_type_info member of reflect specialization.
+	void dump_get_type_info(const member_output& m) const
+	{
+		std::string body;
+		llvm::raw_string_ostream out(body);
+		out << "#if GREFLECT_REGISTRY\n";
+		out << "\t\treturn " << get_variable_name() << ";\n";
+		out << "#else\n";
+		out << "\t\tstatic constexpr reflect_type_info info = {\n";
+		dump_initializer(out, "\t\t\t");
+		out << "\t\t};\n\t\treturn info;\n";
+		out << "#endif // GREFLECT_REGISTRY\n";
+		m.dump("const reflect_type_info&", "get_type_info()", out.str());
+	}
+
+private:
+	std::string get_variable_name() const
+	{
+		return "greflect_type_info_" + m_type_name;
+	}
+
+	void dump_initializer(clang::raw_ostream& out, const char* indent) const
+	{
+		out << indent << utils::fnv1a(m_qualified_name) << "u, \"" << m_kind << "\", \"" << m_name
+		    << "\", \"" << m_qualified_name << "\", \"" << m_type_name << "\"\n";
+	}
+
+private:
+	std::string m_kind;
+	std::string m_name;
+	std::string m_qualified_name;
+	std::string m_type_name;
+}; // class type_info_output
+
+#endif // TYPE_INFO_OUTPUT_HPP
@@ -1,58 +1,183 @@
-/*
-* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
-* Permission is hereby granted, free of charge, to any person obtaining a copy
-* of this software and associated documentation files (the "Software"), to deal
-* in the Software without restriction, including without limitation the rights
-* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-* copies of the Software, and to permit persons to whom the Software is
-* furnished to do so, subject to the following conditions:
-*/
-
-#ifndef UTILS_HPP
-#define UTILS_HPP
-
-#include <clang/Basic/FileManager.h>
-
-#include <string>
-#include <vector>
-
-namespace utils {
-
-bool exist_file(const std::string& file_name)
-{
-	static clang::FileSystemOptions fs_opts;
-	static clang::FileManager fm(fs_opts);
-	return 0 != fm.getFile(file_name.c_str());
-}
-
-std::string generate_out_file_name(const std::string& in_file)
-{
-	static const std::string prefix = "_reflected.hpp";
-	return in_file.substr(0, in_file.find('.')) + prefix;
-}
-
-void replace(std::string& str, const std::string& from, const std::string& to)
-{
-	std::string::size_type start_pos = 0;
-	while ( std::string::npos != (start_pos = str.find(from, start_pos)) ) {
-		str.replace(start_pos, from.size(), to);
-		start_pos += to.size();
-	}
-}
-
-void split(const std::string& str, std::vector<std::string>& strings, std::string any_of)
-{
-	std::string::size_type b_pos = 0;
-	std::string::size_type e_pos = 0;
-	std::string::size_type step = any_of.size();
-	while (std::string::npos != (e_pos = str.find(any_of, e_pos))) {
-		strings.push_back(str.substr(b_pos, e_pos - b_pos));
-		e_pos += step;
-		b_pos = e_pos;
-	}
-	strings.push_back(str.substr(b_pos, e_pos));
-}
-
-} // namespace utils
-
-#endif // UTILS_HPP
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef UTILS_HPP
+#define UTILS_HPP
+
+#include <clang/AST/ASTContext.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/Mangle.h>
+#include <clang/Basic/FileManager.h>
+#include <clang/Basic/SourceManager.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+//@brief Checks file through file system of compiler, so in-memory
+//       buffers over it are seen as files too.
+bool exist_file(clang::vfs::FileSystem& fs, const std::string& file_name)
+{
+	llvm::ErrorOr<clang::vfs::Status> s = fs.status(file_name);
+	return s && s->isRegularFile();
+}
+
+//@brief Checks that file name '-' stands for standard input or output.
+bool is_standard_stream(const std::string& file_name)
+{
+	return "-" == file_name;
+}
+
+std::string generate_out_file_name(const std::string& in_file)
+{
+	static const std::string prefix = "_reflected.hpp";
+	const std::string::size_type name_pos = in_file.size() - llvm::sys::path::filename(in_file).size();
+	return in_file.substr(0, in_file.find('.', name_pos)) + prefix;
+}
+
+//@brief 32 bit FNV-1a hash, generated code computes the same one.
+std::uint32_t fnv1a(const std::string& str, std::uint32_t h = 2166136261u)
+{
+	for (auto c : str) {
+		h = (h ^ static_cast<unsigned char>(c)) * 16777619u;
+	}
+	return h;
+}
+
+//@brief Generates name of header with one type for split output.
+//       Lives beside output file, which includes it by this name.
+//@param hashed adds hash of qualified name, for names which are the same
+//       after punctuation is replaced
+std::string generate_part_file_name(const std::string& out_file, const std::string& qualified_name,
+				    bool hashed = false)
+{
+	std::string part = qualified_name;
+	for (auto& c : part) {
+		c = std::isalnum(static_cast<unsigned char>(c)) ? c : '_';
+	}
+	if (hashed) {
+		char hash[16];
+		std::snprintf(hash, sizeof(hash), "_%08x", fnv1a(qualified_name));
+		part += hash;
+	}
+	llvm::SmallString<256> p(out_file);
+	llvm::sys::path::replace_extension(p, "");
+	return p.str().str() + "_" + part + ".hpp";
+}
+
+//@brief Generates names of headers of types for split output. Types whose
+//       names collide, also on case insensitive file system, get hashed
+//       names, e.g. 'ns::ring<int*>' and 'ns::ring<int&>'.
+void generate_part_file_names(const std::string& out_file, const std::vector<std::string>& qualified_names,
+			      std::vector<std::string>& file_names)
+{
+	auto get_key = [](std::string n)
+	{
+		std::transform(n.begin(), n.end(), n.begin(), ::tolower);
+		return n;
+	};
+	std::map<std::string, unsigned> counts;
+	for (auto& n : qualified_names) {
+		file_names.push_back(generate_part_file_name(out_file, n));
+		++counts[get_key(file_names.back())];
+	}
+	for (std::size_t i = 0; i < file_names.size(); ++i) {
+		if (1 < counts[get_key(file_names[i])]) {
+			file_names[i] = generate_part_file_name(out_file, qualified_names[i], true);
+		}
+	}
+}
+
+//@brief Generates name of source file of header/source output.
+std::string generate_source_file_name(const std::string& out_file)
+{
+	llvm::SmallString<256> p(out_file);
+	llvm::sys::path::replace_extension(p, ".cpp");
+	return p.str();
+}
+
+//@brief Generates include guard unique for output file. Its name is kept
+//       for reading, hash of absolute path tells apart outputs of the same
+//       name in other directories and names which differ in punctuation.
+std::string generate_include_guard(const std::string& out_file)
+{
+	std::string guard = llvm::sys::path::filename(out_file).str();
+	for (auto& c : guard) {
+		c = std::isalnum(static_cast<unsigned char>(c)) ? std::toupper(static_cast<unsigned char>(c)) : '_';
+	}
+	if (guard.empty() || std::isdigit(static_cast<unsigned char>(guard[0]))) {
+		guard = "GREFLECT_" + guard;
+	}
+	llvm::SmallString<256> path(out_file);
+	llvm::sys::fs::make_absolute(path);
+	llvm::sys::path::remove_dots(path, true);
+	char hash[16];
+	std::snprintf(hash, sizeof(hash), "_%08X", fnv1a(path.str().str()));
+	return guard + hash;
+}
+
+//@brief Gets name returned by std::type_info::name for given type.
+std::string get_rtti_name(const clang::TypeDecl* d)
+{
+	clang::ASTContext& c = d->getASTContext();
+	std::unique_ptr<clang::MangleContext> mangler(c.createMangleContext());
+	std::string name;
+	llvm::raw_string_ostream out(name);
+	mangler->mangleCXXRTTIName(c.getTypeDeclType(d), out);
+	out.flush();
+	static const std::string prefix = "_ZTS";
+	return 0 == name.compare(0, prefix.size(), prefix) ? name.substr(prefix.size()) : name;
+}
+
+//@brief Gets sorted names of all files source manager has read.
+void get_file_names(const clang::SourceManager& sc_mgr, std::vector<std::string>& names)
+{
+	for (clang::SourceManager::fileinfo_iterator i = sc_mgr.fileinfo_begin(); i != sc_mgr.fileinfo_end(); ++i) {
+		names.push_back(i->first->getName());
+	}
+	std::sort(names.begin(), names.end());
+}
+
+void replace(std::string& str, const std::string& from, const std::string& to)
+{
+	std::string::size_type start_pos = 0;
+	while ( std::string::npos != (start_pos = str.find(from, start_pos)) ) {
+		str.replace(start_pos, from.size(), to);
+		start_pos += to.size();
+	}
+}
+
+void split(const std::string& str, std::vector<std::string>& strings, std::string any_of)
+{
+	std::string::size_type b_pos = 0;
+	std::string::size_type e_pos = 0;
+	std::string::size_type step = any_of.size();
+	while (std::string::npos != (e_pos = str.find(any_of, e_pos))) {
+		strings.push_back(str.substr(b_pos, e_pos - b_pos));
+		e_pos += step;
+		b_pos = e_pos;
+	}
+	strings.push_back(str.substr(b_pos, e_pos));
+}
+
+} // namespace utils
+
+#endif // UTILS_HPP
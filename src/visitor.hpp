@@ -1,101 +1,265 @@
-/*
-* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
-* Permission is hereby granted, free of charge, to any person obtaining a copy
-* of this software and associated documentation files (the "Software"), to deal
-* in the Software without restriction, including without limitation the rights
-* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
-* copies of the Software, and to permit persons to whom the Software is
-* furnished to do so, subject to the following conditions:
-*/
-
-#ifndef VISITOR_HPP
-#define VISITOR_HPP
-
-#include "debug.hpp"
-#include "messenger.hpp"
-#include "reflect_class.hpp"
-
-#include <clang/AST/ASTConsumer.h>
-#include <clang/AST/Decl.h>
-#include <clang/AST/RecursiveASTVisitor.h>
-#include <clang/Rewrite/Core/Rewriter.h>
-#include <clang/Tooling/Tooling.h>
-
-#include <map>
-
-namespace reflector {
-
-// @class visitor
-class visitor : public clang::RecursiveASTVisitor<visitor>
-{
-public:
-        explicit visitor(const clang::SourceManager& sm)
-		: m_source_mgr(sm)
-        {
-        }
-
-	virtual bool VisitCXXRecordDecl(clang::CXXRecordDecl* d)
-	{
-		ASSERT(0 != d);
-		if (supported(d)) {
-			m_collection.push_back(reflected_class::ptr(new reflected_class(d)));
-		}
-		return true;
-	}
-	
-	bool has_reflected_class() const
-	{
-		return !m_collection.empty();
-	}
-
-	const reflected_class::reflected_collection& get_reflected_classes() const
-	{
-		return m_collection;
-	}
-
-private:
-	bool supported(clang::CXXRecordDecl* d) const
-	{
-		ASSERT(0 != d);
-		if (!d->isClass() || !m_source_mgr.isInMainFile(d->getLocStart())) {
-			return false;
-		}
-		if (!d->hasDefinition()) {
-			massenger::print("Skip reflection of class '" 
-				+ d->getNameAsString() + "', becouse has not definition in given file.");
-			return false;
-		}
-		if (0 != d->getDescribedClassTemplate()) {
-			massenger::print("Skip reflection of class '" + d->getNameAsString()
-								+ "', becouse it described template.");
-			return false;
-		}
-		return true;
-	}
-
-private:
-	const clang::SourceManager& m_source_mgr;
-	reflected_class::reflected_collection m_collection;
-}; // class visitor
-
-// @class consumer
-class consumer : public clang::ASTConsumer
-{
-public:
-	explicit consumer(visitor& v)
-		: m_visitor(v)
-	{
-	}
-
-        virtual void HandleTranslationUnit(clang::ASTContext& c)
-        {
-                m_visitor.TraverseDecl(c.getTranslationUnitDecl());
-        }
-
-private:
-        visitor& m_visitor;
-}; // class consumer
-
-} // namespace reflector
-
-#endif // VISITOR_HPP
+/*
+* Copyright (C) 2016 Vladimir Antonyan <antonyan_v@outlook.com>
+* Permission is hereby granted, free of charge, to any person obtaining a copy
+* of this software and associated documentation files (the "Software"), to deal
+* in the Software without restriction, including without limitation the rights
+* to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+* copies of the Software, and to permit persons to whom the Software is
+* furnished to do so, subject to the following conditions:
+*/
+
+#ifndef VISITOR_HPP
+#define VISITOR_HPP
+
+#include "debug.hpp"
+#include "extractor.hpp"
+#include "messenger.hpp"
+#include "model.hpp"
+#include "selection.hpp"
+#include "statistics.hpp"
+
+#include <clang/AST/ASTConsumer.h>
+#include <clang/AST/Decl.h>
+#include <clang/AST/DeclTemplate.h>
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <clang/Rewrite/Core/Rewriter.h>
+#include <clang/Tooling/Tooling.h>
+
+#include <functional>
+#include <map>
+#include <vector>
+
+namespace reflector {
+
+// @class visitor
+// @brief Collects reflected types of main file. Declarations of other
+//        files and functions are not descended into, they can not
+//        contain anything to reflect.
+class visitor : public clang::RecursiveASTVisitor<visitor>
+{
+private:
+	typedef clang::RecursiveASTVisitor<visitor> base;
+public:
+	typedef std::function<void(const model::record&)> record_handler;
+public:
+        //@param t gets counts of visited and skipped types and time of extraction
+        visitor(const clang::SourceManager& sm, const selection& s, statistics& t)
+		: m_source_mgr(sm)
+		, m_selection(s)
+		, m_stats(t)
+		, m_skipped()
+		, m_extractor(s, m_skipped)
+        {
+        }
+
+	bool TraverseDecl(clang::Decl* d)
+	{
+		if (0 == d || is_pruned(d)) {
+			return true;
+		}
+		return base::TraverseDecl(d);
+	}
+
+	bool shouldWalkTypesOfTypeLocs() const
+	{
+		return false;
+	}
+
+	virtual bool VisitCXXRecordDecl(clang::CXXRecordDecl* d)
+	{
+		ASSERT(0 != d);
+		if (!supported(d)) {
+			return true;
+		}
+		statistics::timer t(m_stats, statistics::phase_extraction);
+		if (m_record_handler) {
+			m_record_handler(m_extractor.extract(d));
+		} else {
+			m_unit.classes.push_back(m_extractor.extract(d));
+		}
+		return true;
+	}
+
+	//@brief Reflects implicit instantiations of class template, they are
+	//       not declared in any context, so traversal does not reach them.
+	//       Explicit specializations and instantiations are reached where
+	//       they are written.
+	virtual bool VisitClassTemplateDecl(clang::ClassTemplateDecl* d)
+	{
+		ASSERT(0 != d);
+		if (!d->isThisDeclarationADefinition()) {
+			return true;
+		}
+		for (auto s : d->specializations()) {
+			if (clang::TSK_ImplicitInstantiation == s->getSpecializationKind()) {
+				VisitCXXRecordDecl(s);
+			}
+		}
+		return true;
+	}
+
+	virtual bool VisitEnumDecl(clang::EnumDecl* d)
+	{
+		ASSERT(0 != d);
+		if (supported(d)) {
+			statistics::timer t(m_stats, statistics::phase_extraction);
+			m_unit.enums.push_back(m_extractor.extract(d));
+		}
+		return true;
+	}
+	
+	//@brief Passes each class to h as soon as it is extracted, instead
+	//       of keeping it in unit.
+	void set_record_handler(const record_handler& h)
+	{
+		m_record_handler = h;
+	}
+
+	//@brief Gets model of reflected types.
+	const model::unit& get_unit() const
+	{
+		return m_unit;
+	}
+
+	//@brief Gets counts of declarations left out by selection.
+	const selection::skipped& get_skipped() const
+	{
+		return m_skipped;
+	}
+
+private:
+	bool is_pruned(clang::Decl* d) const
+	{
+		if (clang::isa<clang::TranslationUnitDecl>(d)) {
+			return false;
+		}
+		return clang::isa<clang::FunctionDecl>(d) || clang::isa<clang::FunctionTemplateDecl>(d) ||
+		       !m_source_mgr.isInMainFile(d->getLocation());
+	}
+
+	bool supported(clang::CXXRecordDecl* d)
+	{
+		ASSERT(0 != d);
+		if ((!d->isClass() && !d->isStruct() && !d->isUnion()) || d->isLambda() ||
+		    !m_source_mgr.isInMainFile(d->getLocStart())) {
+			return false;
+		}
+		const clang::ClassTemplateSpecializationDecl* s = clang::dyn_cast<clang::ClassTemplateSpecializationDecl>(d);
+		if (0 != s && !s->hasDefinition()) {
+			// @note: Template is only named with these arguments.
+			return false;
+		}
+		if (!d->hasDefinition()) {
+			massenger::print("Skip reflection of class '" 
+				+ d->getNameAsString() + "', becouse has not definition in given file.");
+			m_stats.add_skipped("class without definition");
+			return false;
+		}
+		if (d != d->getDefinition()) {
+			return false;
+		}
+		m_stats.add_visited_class();
+		if (0 == d->getIdentifier() || d->isInvalidDecl()) {
+			m_stats.add_skipped("unnamed or invalid class");
+			return false;
+		}
+		if (0 != d->getDescribedClassTemplate()) {
+			massenger::print("Skip reflection of class '" + d->getNameAsString()
+								+ "', becouse it described template.");
+			m_stats.add_skipped("class template");
+			return false;
+		}
+		if (d->isDependentContext()) {
+			massenger::print("Skip reflection of class '" + d->getNameAsString()
+					 + "', becouse it is partial specialization or member of template.");
+			m_stats.add_skipped("class template");
+			return false;
+		}
+		if (0 != s && !s->isExplicitSpecialization() &&
+		    !m_source_mgr.isInMainFile(s->getSpecializedTemplate()->getLocation())) {
+			m_stats.add_skipped("instantiation of template of other file");
+			return false;
+		}
+		if (!m_selection.is_selected(d)) {
+			++m_skipped.classes;
+			m_stats.add_skipped("class left out by selection");
+			return false;
+		}
+		return true;
+	}
+
+	bool supported(clang::EnumDecl* d)
+	{
+		ASSERT(0 != d);
+		if (!d->isCompleteDefinition() || !m_source_mgr.isInMainFile(d->getLocStart())) {
+			return false;
+		}
+		if (0 == d->getIdentifier() || d->isDependentContext() || 0 != d->getParentFunctionOrMethod()) {
+			massenger::print("Skip reflection of unnamed, local or template member enum.");
+			m_stats.add_skipped("unnamed, local or template member enum");
+			return false;
+		}
+		if (clang::AS_private == d->getAccess() || clang::AS_protected == d->getAccess()) {
+			massenger::print("Skip reflection of enum '" + d->getNameAsString() + "', becouse it is not public.");
+			m_stats.add_skipped("enum which is not public");
+			return false;
+		}
+		if (d->enumerator_begin() == d->enumerator_end()) {
+			massenger::print("Skip reflection of enum '" + d->getNameAsString() + "', becouse it has not values.");
+			m_stats.add_skipped("enum without values");
+			return false;
+		}
+		if (!m_selection.is_selected(d)) {
+			++m_skipped.enums;
+			m_stats.add_skipped("enum left out by selection");
+			return false;
+		}
+		return true;
+	}
+
+private:
+	const clang::SourceManager& m_source_mgr;
+	const selection& m_selection;
+	statistics& m_stats;
+	selection::skipped m_skipped;
+	extractor m_extractor;
+	record_handler m_record_handler;
+	model::unit m_unit;
+}; // class visitor
+
+// @class consumer
+// @brief Traverses top level declarations parsed from input, not whole
+//        translation unit, so declarations of precompiled header are not
+//        loaded.
+class consumer : public clang::ASTConsumer
+{
+public:
+	consumer(visitor& v, statistics& s)
+		: m_visitor(v)
+		, m_stats(s)
+	{
+	}
+
+	virtual bool HandleTopLevelDecl(clang::DeclGroupRef g)
+	{
+		m_decls.insert(m_decls.end(), g.begin(), g.end());
+		return true;
+	}
+
+        virtual void HandleTranslationUnit(clang::ASTContext&)
+        {
+		statistics::timer t(m_stats, statistics::phase_traversal);
+		for (auto d : m_decls) {
+			m_visitor.TraverseDecl(d);
+		}
+        }
+
+private:
+        visitor& m_visitor;
+	statistics& m_stats;
+	std::vector<clang::Decl*> m_decls;
+}; // class consumer
+
+} // namespace reflector
+
+#endif // VISITOR_HPP
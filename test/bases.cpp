@@ -0,0 +1,22 @@
+/*
+* Checks is_derived_from with qualified base names without tag keyword.
+*/
+
+#include "bases.hpp"
+#include "bases_reflected.hpp"
+
+#include <cassert>
+#include <iostream>
+
+int main()
+{
+	typedef reflect<ns::circle> r;
+	assert(r::is_derived_from("ns::shape"));
+	assert(r::is_derived_from("ns::named"));
+	assert(r::is_derived_from("ns::holder<double>"));
+	assert(!r::is_derived_from("class ns::shape"));
+	assert(!r::is_derived_from("ns::circle"));
+	assert(!reflect<ns::named>::is_derived_from("ns::shape"));
+	std::cout << "bases: ok" << std::endl;
+	return 0;
+}
@@ -0,0 +1,36 @@
+/*
+* Input of base names check, see 'make check'.
+* Bases are class, struct and template instantiation, all in namespace.
+*/
+
+#ifndef BASES_HPP
+#define BASES_HPP
+
+namespace ns {
+
+class shape
+{
+public:
+	virtual ~shape() {}
+};
+
+struct named
+{
+	int id = 0;
+};
+
+template <typename T>
+struct holder
+{
+	T value = T();
+};
+
+class circle : public shape, public named, public holder<double>
+{
+public:
+	double r = 1;
+};
+
+} // namespace ns
+
+#endif // BASES_HPP
@@ -0,0 +1,23 @@
+/*
+* Input of layout check of selected fields, see 'make check'.
+* With -a only counter::hits is reflected, layout report still shows
+* counter::owner, and false sharing check finds counter::lock beside hits.
+*/
+
+#ifndef SELECTION_HPP
+#define SELECTION_HPP
+
+#define REFLECT __attribute__((annotate("reflect")))
+
+namespace ns {
+
+struct counter
+{
+	int REFLECT __attribute__((annotate("per_thread"))) hits;
+	long owner;
+	int __attribute__((annotate("per_thread"))) lock;
+};
+
+} // namespace ns
+
+#endif // SELECTION_HPP
@@ -0,0 +1,31 @@
+/*
+* Input of template sharing check, see 'make check'.
+* get has the same parameters as size, so reflect of instantiation can not
+* have both invokes. size must not move to shared body, where invoke of get
+* would hide it and the call would fail only at run time; generated header
+* is expected not to compile.
+*/
+
+#ifndef TEMPLATE_HIDING_HPP
+#define TEMPLATE_HIDING_HPP
+
+namespace ns {
+
+template <typename T>
+struct foo
+{
+	unsigned long size() const { return n; }
+	void clear() { n = 0; }
+	T get() const { return T(n); }
+	unsigned long n = 3;
+};
+
+struct user
+{
+	foo<int> i;
+	foo<double> d;
+};
+
+} // namespace ns
+
+#endif // TEMPLATE_HIDING_HPP
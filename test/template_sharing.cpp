@@ -0,0 +1,45 @@
+/*
+* Checks invokes of instantiations which share reflect_template body.
+* Built with REFLECT_PROFILE it writes profile to file given as argument.
+*/
+
+#include "template_sharing.hpp"
+#include "template_sharing_reflected.hpp"
+
+#include <cassert>
+#include <fstream>
+#include <iostream>
+
+template <typename T>
+void check()
+{
+	typedef ns::foo<T> type;
+	type o;
+	const type& c = o;
+	assert(3 == reflect<type>::invoke(c, "size"));
+	assert(T(4) == reflect<type>::invoke(c, "get", 1ul));
+	reflect<type>::invoke(o, "clear");
+	assert(0 == reflect<type>::invoke(c, "size"));
+	std::set<std::string> ns;
+	reflect<type>::get_methods(ns);
+	assert(3 == ns.size());
+}
+
+int main(int argc, char** argv)
+{
+	check<int>();
+	check<double>();
+	typedef ns::entry<int, double> entry;
+	entry e;
+	reflect<entry>::invoke(e, "set_value", 2.5);
+	assert(2.5 == e.v);
+	assert(1 == reflect<entry>::invoke(static_cast<const entry&>(e), "get_key"));
+#ifdef REFLECT_PROFILE
+	if (1 < argc) {
+		std::ofstream out(argv[1]);
+		reflect_profile::dump(out);
+	}
+#endif // REFLECT_PROFILE
+	std::cout << "template sharing: ok" << std::endl;
+	return 0;
+}
@@ -0,0 +1,40 @@
+/*
+* Input of template sharing check, see 'make check'.
+* Instantiations share size and clear, get differs in return type and stays
+* in reflect of each instantiation. Name of entry<int, double> has space,
+* its profile counts are read back by 'greflect -p'.
+*/
+
+#ifndef TEMPLATE_SHARING_HPP
+#define TEMPLATE_SHARING_HPP
+
+namespace ns {
+
+template <typename T>
+struct foo
+{
+	unsigned long size() const { return n; }
+	void clear() { n = 0; }
+	T get(unsigned long i) const { return T(n + i); }
+	unsigned long n = 3;
+};
+
+template <typename K, typename V>
+struct entry
+{
+	K get_key() const { return k; }
+	void set_value(V x) { v = x; }
+	K k = 1;
+	V v = 0;
+};
+
+struct user
+{
+	foo<int> i;
+	foo<double> d;
+	entry<int, double> e;
+};
+
+} // namespace ns
+
+#endif // TEMPLATE_SHARING_HPP